@@ -33,11 +33,18 @@
 
 // Standard includes
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <map>
+#include <limits>
 #include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -101,55 +108,416 @@ getFile(std::string const &fn,
     }
     return os.str();
 }
-#else
-#include <cstring> // strerror
 
-std::string
-getFile(std::string const &fn,
-        std::function<void(std::string const &)> const &errorReport) {
-    std::ifstream s(fn, std::ios::in | std::ios::binary);
-    if (!s) {
-        std::ostringstream os;
-        os << "Could not open file ";
-
-        /// Sadly errno is far more useful in its error messages than
-        /// failbit-triggered exceptions, etc.
-        auto theErrno = errno;
-        os << " (Error code: " << theErrno << " - " << strerror(theErrno)
-           << ")";
-        errorReport(os.str());
-        return std::string{};
+static inline bool
+withFileContents(std::string const &fn,
+                 std::function<void(std::string const &)> const &errorReport,
+                 std::function<void(const char *, const char *)> const &use) {
+    bool failed = false;
+    std::string data = getFile(fn, [&](std::string const &message) {
+        failed = true;
+        errorReport(message);
+    });
+    if (failed) {
+        return false;
     }
+    use(data.data(), data.data() + data.size());
+    return true;
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline std::string formatErrno() {
+    /// Sadly errno is far more useful in its error messages than
+    /// failbit-triggered exceptions, etc.
+    auto theErrno = errno;
     std::ostringstream os;
-    std::string temp;
-    while (std::getline(s, temp)) {
-        os << temp;
-    }
+    os << " (Error code: " << theErrno << " - " << strerror(theErrno) << ")";
     return os.str();
 }
+
+/// Maps the file read-only and hands its contents to the callback, so it can
+/// be parsed in place, without copying it into a string first.
+static inline bool
+withFileContents(std::string const &fn,
+                 std::function<void(std::string const &)> const &errorReport,
+                 std::function<void(const char *, const char *)> const &use) {
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0) {
+        errorReport("Could not open file" + formatErrno());
+        return false;
+    }
+    auto closer = osvr::util::finally([&fd] { close(fd); });
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        errorReport("Could not get file size" + formatErrno());
+        return false;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) {
+        /// Can't map an empty file - but there's nothing to map anyway.
+        use(nullptr, nullptr);
+        return true;
+    }
+    void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem == MAP_FAILED) {
+        errorReport("Could not map file" + formatErrno());
+        return false;
+    }
+    auto unmapper = osvr::util::finally([&] { munmap(mem, size); });
+    auto begin = static_cast<const char *>(mem);
+    use(begin, begin + size);
+    return true;
+}
 #endif
 
 namespace osvr {
 namespace vive {
     static const auto PREFIX = "[ChaperoneData] ";
     static const auto CHAPERONE_DATA_FILENAME = "chaperone_info.vrchap";
+    /// Kept next to the chaperone data, so it's naturally per-user.
+    static const auto CHAPERONE_CACHE_FILENAME = "chaperone_info.osvrcache";
+    static const std::uint64_t CHAPERONE_CACHE_MAGIC = 0x4843505245564956ULL;
+    /// Bump whenever what's cached, or how, changes.
+    static const std::uint32_t CHAPERONE_CACHE_VERSION = 2;
 #ifdef _WIN32
     static const auto PATH_SEPARATOR = "\\";
 #else
     static const auto PATH_SEPARATOR = "/";
 #endif
 
-    using UniverseDataMap =
-        std::map<std::uint64_t, ChaperoneData::UniverseData>;
+    /// Sorted by ID, no duplicates: few enough, and looked up rarely enough,
+    /// that a binary search over contiguous memory beats a tree.
+    using UniverseDataTable =
+        std::vector<std::pair<std::uint64_t, ChaperoneData::UniverseData>>;
+
+    /// A universe entry from the file, for guessing: the serials it lists
+    /// are in the inverted index instead.
+    struct UniverseBaseStations {
+        std::uint64_t id;
+        /// How many base stations it lists (duplicates included).
+        std::size_t numSerials;
+    };
+    /// Indices into ChaperoneData::Impl::baseStations
+    using UniverseIndices = std::vector<std::uint32_t>;
+
+    /// What the cache is keyed by: the chaperone file's size and
+    /// modification time are checked first, but it's the hash of its
+    /// contents that decides.
+    struct FileStamp {
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+        std::uint64_t hash = 0;
+    };
+
+    static bool getFileStamp(std::string const &fn, FileStamp &stamp) {
+        struct stat st;
+        if (stat(fn.c_str(), &st) != 0) {
+            return false;
+        }
+        stamp.size = static_cast<std::uint64_t>(st.st_size);
+        stamp.mtime = static_cast<std::int64_t>(st.st_mtime);
+        return true;
+    }
+
+    /// 64-bit FNV-1a
+    static std::uint64_t hashContents(const char *begin, const char *end) {
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for (auto p = begin; p != end; ++p) {
+            hash ^= static_cast<unsigned char>(*p);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    /// Appends plain values to the cache in native byte order - it never
+    /// leaves the machine that wrote it, and the magic number won't match
+    /// on one with the other byte order anyway.
+    class CacheWriter {
+      public:
+        template <typename T> void put(T const &value) {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "Only plain values can be written directly.");
+            buf_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+        void putString(std::string const &str) {
+            put(static_cast<std::uint64_t>(str.size()));
+            buf_.append(str);
+        }
+        std::string const &data() const { return buf_; }
+
+      private:
+        std::string buf_;
+    };
+
+    /// Reads what CacheWriter wrote, failing (rather than reading past the
+    /// end) on a truncated or corrupt cache.
+    class CacheReader {
+      public:
+        CacheReader(const char *begin, const char *end)
+            : cur_(begin), end_(end) {}
+        template <typename T> bool get(T &value) {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "Only plain values can be read directly.");
+            if (remaining() < sizeof(T)) {
+                return false;
+            }
+            std::memcpy(&value, cur_, sizeof(T));
+            cur_ += sizeof(T);
+            return true;
+        }
+        bool getString(std::string &str) {
+            std::uint64_t size;
+            if (!get(size) || remaining() < size) {
+                return false;
+            }
+            str.assign(cur_, static_cast<std::size_t>(size));
+            cur_ += size;
+            return true;
+        }
+        /// Gets a count of things still to be read, each at least one byte,
+        /// so a corrupt count can't set off a huge loop or allocation.
+        bool getCount(std::uint64_t &count) {
+            return get(count) && count <= remaining();
+        }
+        std::size_t remaining() const {
+            return static_cast<std::size_t>(end_ - cur_);
+        }
+
+      private:
+        const char *cur_;
+        const char *end_;
+    };
 
-    using UniverseBaseSerials = std::vector<
-        std::pair<std::uint64_t, ChaperoneData::BaseStationSerials>>;
     struct ChaperoneData::Impl {
-        Json::Value chaperoneInfo;
-        UniverseDataMap universes;
-        UniverseBaseSerials baseSerials;
+        UniverseDataTable universes;
+        /// In file order - which is also the order of preference when
+        /// guessing turns up a tie.
+        std::vector<UniverseBaseStations> baseStations;
+        /// Base station serials, interned to indices into
+        /// universesBySerial.
+        std::unordered_map<std::string, std::uint32_t> serialIds;
+        /// The inverted index: per interned serial, the universes listing
+        /// it (each once, in file order).
+        std::vector<UniverseIndices> universesBySerial;
+
+        /// @name Scratch space for guessing
+        /// @{
+        /// Per universe, how many provided serials it lists.
+        std::vector<std::size_t> hits;
+        /// Universes with nonzero hits.
+        UniverseIndices hitUniverses;
+        /// @}
+
+        /// Writes everything loaded (and the warnings from loading it) to
+        /// the cache file, replacing any old one. Failure isn't an error,
+        /// just a slower start next time.
+        void saveCache(std::string const &fn, FileStamp const &stamp,
+                       std::string const &warnings) const;
+        /// @return false (leaving this untouched) unless the cache file
+        /// exists, is intact, and was written from a file with this stamp.
+        bool loadCache(std::string const &fn, FileStamp const &stamp,
+                       std::string &warnings);
+
+        void addBaseStation(std::string const &serial,
+                            std::uint32_t universeIndex) {
+            auto result = serialIds.emplace(
+                serial, static_cast<std::uint32_t>(universesBySerial.size()));
+            if (result.second) {
+                universesBySerial.emplace_back();
+            }
+            auto &universeIndices = universesBySerial[result.first->second];
+            /// A universe listing a serial twice still only counts it once.
+            if (universeIndices.empty() ||
+                universeIndices.back() != universeIndex) {
+                universeIndices.push_back(universeIndex);
+            }
+        }
     };
 
+    void ChaperoneData::Impl::saveCache(std::string const &fn,
+                                        FileStamp const &stamp,
+                                        std::string const &warnings) const {
+        CacheWriter out;
+        out.put(CHAPERONE_CACHE_MAGIC);
+        out.put(CHAPERONE_CACHE_VERSION);
+        out.put(stamp.size);
+        out.put(stamp.mtime);
+        out.put(stamp.hash);
+
+        out.put(static_cast<std::uint64_t>(universes.size()));
+        for (auto const &univ : universes) {
+            out.put(univ.first);
+            out.put(static_cast<std::uint32_t>(univ.second.type));
+            out.put(univ.second.translation);
+            out.put(univ.second.yaw);
+            auto const &bounds = univ.second.bounds;
+            out.put(static_cast<std::uint64_t>(bounds.size()));
+            for (std::size_t i = 0; i < bounds.size(); ++i) {
+                out.put(bounds.startX(i));
+                out.put(bounds.startZ(i));
+                out.put(bounds.endX(i));
+                out.put(bounds.endZ(i));
+            }
+        }
+
+        out.put(static_cast<std::uint64_t>(baseStations.size()));
+        for (auto const &univ : baseStations) {
+            out.put(univ.id);
+            out.put(static_cast<std::uint64_t>(univ.numSerials));
+        }
+
+        /// The serials, in interned order, each with its universes.
+        std::vector<std::string const *> serials(universesBySerial.size());
+        for (auto const &serialId : serialIds) {
+            serials[serialId.second] = &serialId.first;
+        }
+        out.put(static_cast<std::uint64_t>(serials.size()));
+        for (std::size_t i = 0; i < serials.size(); ++i) {
+            out.putString(*serials[i]);
+            auto const &universeIndices = universesBySerial[i];
+            out.put(static_cast<std::uint64_t>(universeIndices.size()));
+            for (auto universeIndex : universeIndices) {
+                out.put(universeIndex);
+            }
+        }
+        out.putString(warnings);
+        /// Last, a hash of everything before it, to catch corruption.
+        out.put(hashContents(out.data().data(),
+                             out.data().data() + out.data().size()));
+
+        /// Written under another name then renamed over the old one, so a
+        /// reader never sees it half-written.
+        auto tempFn = fn + ".tmp";
+        {
+            std::ofstream file(tempFn, std::ios::out | std::ios::binary |
+                                           std::ios::trunc);
+            if (!file ||
+                !file.write(out.data().data(),
+                            static_cast<std::streamsize>(out.data().size()))) {
+                file.close();
+                std::remove(tempFn.c_str());
+                return;
+            }
+        }
+#ifdef _WIN32
+        /// Won't rename over an existing file.
+        std::remove(fn.c_str());
+#endif
+        if (std::rename(tempFn.c_str(), fn.c_str()) != 0) {
+            std::remove(tempFn.c_str());
+        }
+    }
+
+    bool ChaperoneData::Impl::loadCache(std::string const &fn,
+                                        FileStamp const &stamp,
+                                        std::string &warnings) {
+        Impl loaded;
+        std::string loadedWarnings;
+        auto read = [&](const char *begin, const char *end) {
+            std::uint64_t hash;
+            if (static_cast<std::size_t>(end - begin) < sizeof(hash)) {
+                return false;
+            }
+            end -= sizeof(hash);
+            std::memcpy(&hash, end, sizeof(hash));
+            if (hash != hashContents(begin, end)) {
+                return false;
+            }
+            CacheReader in(begin, end);
+            std::uint64_t magic;
+            std::uint32_t version;
+            FileStamp cachedStamp;
+            if (!in.get(magic) || magic != CHAPERONE_CACHE_MAGIC ||
+                !in.get(version) || version != CHAPERONE_CACHE_VERSION ||
+                !in.get(cachedStamp.size) || cachedStamp.size != stamp.size ||
+                !in.get(cachedStamp.mtime) ||
+                cachedStamp.mtime != stamp.mtime ||
+                !in.get(cachedStamp.hash) || cachedStamp.hash != stamp.hash) {
+                return false;
+            }
+
+            std::uint64_t count;
+            if (!in.getCount(count)) {
+                return false;
+            }
+            loaded.universes.resize(static_cast<std::size_t>(count));
+            for (auto &univ : loaded.universes) {
+                std::uint32_t type;
+                if (!in.get(univ.first) || !in.get(type) ||
+                    type > static_cast<std::uint32_t>(
+                               CalibrationType::Seated) ||
+                    !in.get(univ.second.translation) ||
+                    !in.get(univ.second.yaw)) {
+                    return false;
+                }
+                univ.second.type = static_cast<CalibrationType>(type);
+                std::uint64_t numSegments;
+                if (!in.getCount(numSegments)) {
+                    return false;
+                }
+                for (std::uint64_t i = 0; i < numSegments; ++i) {
+                    std::array<double, 4> segment;
+                    if (!in.get(segment)) {
+                        return false;
+                    }
+                    univ.second.bounds.addSegment(segment[0], segment[1],
+                                                  segment[2], segment[3]);
+                }
+            }
+
+            if (!in.getCount(count)) {
+                return false;
+            }
+            loaded.baseStations.resize(static_cast<std::size_t>(count));
+            for (auto &univ : loaded.baseStations) {
+                std::uint64_t numSerials;
+                if (!in.get(univ.id) || !in.get(numSerials)) {
+                    return false;
+                }
+                univ.numSerials = static_cast<std::size_t>(numSerials);
+            }
+
+            if (!in.getCount(count)) {
+                return false;
+            }
+            loaded.universesBySerial.resize(static_cast<std::size_t>(count));
+            for (std::uint32_t i = 0; i < loaded.universesBySerial.size();
+                 ++i) {
+                std::string serial;
+                std::uint64_t numUniverses;
+                if (!in.getString(serial) || !in.getCount(numUniverses) ||
+                    !loaded.serialIds.emplace(std::move(serial), i).second) {
+                    return false;
+                }
+                auto &universeIndices = loaded.universesBySerial[i];
+                universeIndices.resize(static_cast<std::size_t>(numUniverses));
+                for (auto &universeIndex : universeIndices) {
+                    if (!in.get(universeIndex) ||
+                        !(universeIndex < loaded.baseStations.size())) {
+                        return false;
+                    }
+                }
+            }
+            return in.getString(loadedWarnings) && in.remaining() == 0;
+        };
+        bool ok = false;
+        withFileContents(fn, [](std::string const &) {},
+                         [&](const char *begin, const char *end) {
+                             ok = read(begin, end);
+                         });
+        if (!ok) {
+            return false;
+        }
+        loaded.hits.resize(loaded.baseStations.size());
+        *this = std::move(loaded);
+        warnings = std::move(loadedWarnings);
+        return true;
+    }
+
     void loadJsonIntoUniverseData(Json::Value const &obj,
                                   ChaperoneData::UniverseData &data) {
         data.yaw = obj["yaw"].asDouble();
@@ -158,57 +526,100 @@ namespace vive {
             data.translation[i] = xlate[i].asDouble();
         }
     }
+
+    /// Each wall in "collision_bounds" is a quad of [x, y, z] corners,
+    /// standing straight up from the floor: all we keep is its footprint,
+    /// from the first corner to the one farthest from it in the floor
+    /// plane.
+    static void loadJsonIntoBounds(Json::Value const &univ,
+                                   PlayAreaBounds &bounds) {
+        for (auto const &wall : univ["collision_bounds"]) {
+            if (!wall.isArray() || wall.size() < 2) {
+                continue;
+            }
+            auto x0 = wall[0][0].asDouble();
+            auto z0 = wall[0][2].asDouble();
+            auto x1 = x0;
+            auto z1 = z0;
+            auto farthestSq = 0.;
+            for (Json::Value::ArrayIndex i = 1; i < wall.size(); ++i) {
+                auto x = wall[i][0].asDouble();
+                auto z = wall[i][2].asDouble();
+                auto distSq = (x - x0) * (x - x0) + (z - z0) * (z - z0);
+                if (distSq > farthestSq) {
+                    farthestSq = distSq;
+                    x1 = x;
+                    z1 = z;
+                }
+            }
+            if (farthestSq > 0.) {
+                bounds.addSegment(x0, z0, x1, z1);
+            }
+        }
+        if (bounds.empty()) {
+            auto &playArea = univ["play_area"];
+            if (playArea.isArray() && playArea.size() == 2 &&
+                playArea[0].asDouble() > 0. && playArea[1].asDouble() > 0.) {
+                bounds.addCenteredRectangle(playArea[0].asDouble(),
+                                            playArea[1].asDouble());
+            }
+        }
+    }
     ChaperoneData::ChaperoneData(std::string const &steamConfigDir)
         : impl_(new Impl), configDir_(steamConfigDir) {
+        auto cacheFn = configDir_ + PATH_SEPARATOR + CHAPERONE_CACHE_FILENAME;
+        FileStamp stamp;
+        bool haveStamp = false;
+        /// Only needed while loading: everything we use from it is copied
+        /// out into impl_, and the rest freed on the way out.
+        Json::Value chaperoneInfo;
         {
             Json::Reader reader;
-            auto chapInfoFn =
-                configDir_ + PATH_SEPARATOR + CHAPERONE_DATA_FILENAME;
-#if 0
-            std::ifstream chapInfoFile(configDir_,
-                                       std::ios::in | std::ios::binary);
-            if (!chapInfoFile) {
-                std::ostringstream os;
-                os << "Could not open chaperone info file, expected at "
-                   << chapInfoFn;
-
-                /// Sadly errno is far more useful in its error messages than
-                /// failbit-triggered exceptions, etc.
-                auto theErrno = errno;
-                os << " (Error code: " << theErrno << " - "
-                   << strerror(theErrno) << ")";
-                errorOut_(os.str());
-                return;
-            }
-
-            if (!chapInfoFile.good()) {
-                errorOut_("Could not open chaperone info file, expected at " +
-                          chapInfoFn);
-                return;
-            }
-#endif
-            std::string fileData =
-                getFile(chapInfoFn, [&](std::string const &message) {
+            auto chapInfoFn = getDataFilePath(configDir_);
+            haveStamp = getFileStamp(chapInfoFn, stamp);
+            bool cached = false;
+            bool parsed = false;
+            std::string parseErrors;
+            auto opened = withFileContents(
+                chapInfoFn,
+                [&](std::string const &message) {
                     std::ostringstream os;
                     os << "Could not open chaperone info file, expected at "
                        << chapInfoFn;
                     os << " - details [" << message << "]";
                     errorOut_(os.str());
-
+                },
+                [&](const char *begin, const char *end) {
+                    stamp.hash = hashContents(begin, end);
+                    if (haveStamp &&
+                        impl_->loadCache(cacheFn, stamp, err_)) {
+                        cached = true;
+                        return;
+                    }
+                    /// Parsed straight from the mapped file; comments
+                    /// wouldn't be used, so not kept.
+                    parsed = reader.parse(begin, end, chaperoneInfo, false);
+                    if (!parsed) {
+                        /// Has to be formatted while the file is still
+                        /// mapped: the errors point into it.
+                        parseErrors = reader.getFormattedErrorMessages();
+                    }
                 });
-            if (!valid()) {
+            if (!opened) {
                 /// this means our fail handler got called.
                 return;
             }
-            if (!reader.parse(fileData, impl_->chaperoneInfo)) {
+            if (cached) {
+                return;
+            }
+            if (!parsed) {
                 errorOut_("Could not parse JSON in chaperone info file at " +
-                          chapInfoFn + ": " +
-                          reader.getFormattedErrorMessages());
+                          chapInfoFn + ": " + parseErrors);
                 return;
             }
 
             /// Basic sanity checks
-            if (impl_->chaperoneInfo["jsonid"] != "chaperone_info") {
+            if (chaperoneInfo["jsonid"] != "chaperone_info") {
                 errorOut_("Chaperone info file at " + chapInfoFn +
                           " did not match expected format (no element "
                           "\"jsonid\": \"chaperone_info\" in top level "
@@ -216,7 +627,7 @@ namespace vive {
                 return;
             }
 
-            if (impl_->chaperoneInfo["universes"].size() == 0) {
+            if (chaperoneInfo["universes"].size() == 0) {
                 errorOut_("Chaperone info file at " + chapInfoFn +
                           " did not contain any known chaperone universes - "
                           "user must run Room Setup at least once");
@@ -224,7 +635,7 @@ namespace vive {
             }
         }
 
-        for (auto const &univ : impl_->chaperoneInfo["universes"]) {
+        for (auto const &univ : chaperoneInfo["universes"]) {
             auto univIdString = univ["universeID"].asString();
             UniverseData data;
             auto &standing = univ["standing"];
@@ -244,6 +655,7 @@ namespace vive {
             } else {
                 data.type = CalibrationType::Standing;
                 loadJsonIntoUniverseData(standing, data);
+                loadJsonIntoBounds(univ, data.bounds);
             }
             /// Convert universe ID (64-bit int) from string, in JSON, to an int
             /// again.
@@ -251,39 +663,94 @@ namespace vive {
             std::istringstream is(univIdString);
             is >> id;
             /// Add the universe data in.
-            impl_->universes.insert(std::make_pair(id, data));
+            impl_->universes.emplace_back(id, data);
 
-            BaseStationSerials serials;
+            /// Add the serial data in.
+            auto universeIndex =
+                static_cast<std::uint32_t>(impl_->baseStations.size());
+            std::size_t numSerials = 0;
             for (auto const &tracker : univ["trackers"]) {
                 auto &serial = tracker["serial"];
                 if (serial.isString()) {
-                    serials.push_back(serial.asString());
+                    impl_->addBaseStation(serial.asString(), universeIndex);
+                    ++numSerials;
                 }
             }
+            impl_->baseStations.push_back(
+                UniverseBaseStations{id, numSerials});
+        }
+        impl_->hits.resize(impl_->baseStations.size());
 
-            /// Add the serial data in.
-            impl_->baseSerials.emplace_back(id, std::move(serials));
+        /// Sort for lookup - if a universe is listed more than once, the
+        /// first one wins.
+        auto &universes = impl_->universes;
+        auto idLess = [](UniverseDataTable::value_type const &a,
+                         UniverseDataTable::value_type const &b) {
+            return a.first < b.first;
+        };
+        std::stable_sort(begin(universes), end(universes), idLess);
+        universes.erase(
+            std::unique(begin(universes), end(universes),
+                        [](UniverseDataTable::value_type const &a,
+                           UniverseDataTable::value_type const &b) {
+                            return a.first == b.first;
+                        }),
+            end(universes));
+        universes.shrink_to_fit();
+
+        /// Only what loaded cleanly (if with warnings) gets here to be
+        /// cached.
+        if (haveStamp) {
+            impl_->saveCache(cacheFn, stamp, err_);
         }
     }
 
     ChaperoneData::~ChaperoneData() {}
 
+    const char *ChaperoneData::getDataFileName() {
+        return CHAPERONE_DATA_FILENAME;
+    }
+
+    std::string
+    ChaperoneData::getDataFilePath(std::string const &steamConfigDir) {
+        return steamConfigDir + PATH_SEPARATOR + CHAPERONE_DATA_FILENAME;
+    }
+
     bool ChaperoneData::valid() const { return static_cast<bool>(impl_); }
 
-    bool ChaperoneData::knowUniverseId(UniverseId universe) const {
+    /// Binary search of the universe table, including universe 0.
+    static ChaperoneData::UniverseData const *
+    lookupUniverse(UniverseDataTable const &universes,
+                   ChaperoneData::UniverseId universe) {
+        auto it = std::lower_bound(
+            begin(universes), end(universes), universe,
+            [](UniverseDataTable::value_type const &entry,
+               ChaperoneData::UniverseId id) { return entry.first < id; });
+        if (it == end(universes) || it->first != universe) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    ChaperoneData::UniverseData const *
+    ChaperoneData::findUniverse(UniverseId universe) const {
         if (0 == universe) {
-            return false;
+            return nullptr;
         }
-        return (impl_->universes.find(universe) != end(impl_->universes));
+        return lookupUniverse(impl_->universes, universe);
+    }
+
+    bool ChaperoneData::knowUniverseId(UniverseId universe) const {
+        return findUniverse(universe) != nullptr;
     }
 
     ChaperoneData::UniverseData
     ChaperoneData::getDataForUniverse(UniverseId universe) const {
-        auto it = impl_->universes.find(universe);
-        if (it == end(impl_->universes)) {
+        auto data = lookupUniverse(impl_->universes, universe);
+        if (!data) {
             return UniverseData();
         }
-        return it->second;
+        return *data;
     }
 
     std::size_t ChaperoneData::getNumberOfKnownUniverses() const {
@@ -293,51 +760,51 @@ namespace vive {
     ChaperoneData::UniverseId ChaperoneData::guessUniverseIdFromBaseStations(
         BaseStationSerials const &bases) {
         auto providedSize = bases.size();
-        UniverseId ret = 0;
-        using UniverseRank = std::pair<float, UniverseId>;
-        /// Compare function for heap.
-        auto compare = [](UniverseRank const &a, UniverseRank const &b) {
-            return a.first < b.first;
-        };
-
-        /// Will contain heap of potential universes and their value (a fraction
-        /// of their base stations and provided base stations that were included
-        /// in the base station list provided to the function)
-        std::vector<UniverseRank> potentialUniverses;
-        auto push = [&](float value, UniverseId id) {
-            potentialUniverses.emplace_back(value, id);
-            std::push_heap(begin(potentialUniverses), end(potentialUniverses),
-                           compare);
-        };
+        auto &hits = impl_->hits;
+        auto &hitUniverses = impl_->hitUniverses;
+
+        /// Count, for each universe, the number of entries that we were given
+        /// that are also in its list - only touching universes that have any.
+        for (auto const &needle : bases) {
+            auto it = impl_->serialIds.find(needle);
+            if (it == end(impl_->serialIds)) {
+                continue;
+            }
+            for (auto universeIndex : impl_->universesBySerial[it->second]) {
+                if (0 == hits[universeIndex]++) {
+                    hitUniverses.push_back(universeIndex);
+                }
+            }
+        }
 
-        for (auto &univBaseSerial : impl_->baseSerials) {
-            auto const &baseSerials = univBaseSerial.second;
-            std::size_t hits = 0;
-            auto b = begin(baseSerials);
-            auto e = end(baseSerials);
-            /// Count the number of entries that we were given that are also in
-            /// this universe's list.
-            auto found = std::count_if(begin(bases), end(bases),
-                                       [&](std::string const &needle) {
-                                           return std::find(b, e, needle) != e;
-                                       });
-            if (found > 0) {
-                /// This is meant to combine the influence of "found" in both
-                /// providedSize and universe size, and the +1 in the
-                /// denominator is to avoid division by zero.
-                auto weight = 2.f * static_cast<float>(found) /
-                              (baseSerials.size() + providedSize + 1);
+        /// Find the universe with the largest fraction of its base stations
+        /// and provided base stations in common, resetting the scratch
+        /// counts along the way.
+        UniverseId ret = 0;
+        float bestWeight = 0.f;
+        auto bestIndex = std::numeric_limits<std::uint32_t>::max();
+        for (auto universeIndex : hitUniverses) {
+            auto found = hits[universeIndex];
+            hits[universeIndex] = 0;
+            auto const &univ = impl_->baseStations[universeIndex];
+            /// This is meant to combine the influence of "found" in both
+            /// providedSize and universe size, and the +1 in the
+            /// denominator is to avoid division by zero.
+            auto weight = 2.f * static_cast<float>(found) /
+                          (univ.numSerials + providedSize + 1);
 #if 0
-                std::cout << "Guessing produced weight of " << weight << " for "
-                          << univBaseSerial.first << std::endl;
+            std::cout << "Guessing produced weight of " << weight << " for "
+                      << univ.id << std::endl;
 #endif
-                push(weight, univBaseSerial.first);
+            /// Ties go to the universe listed first.
+            if (weight > bestWeight ||
+                (weight == bestWeight && universeIndex < bestIndex)) {
+                bestWeight = weight;
+                bestIndex = universeIndex;
+                ret = univ.id;
             }
         }
-        if (!potentialUniverses.empty()) {
-            /// it's a heap, so the best one is always on top.
-            return potentialUniverses.front().second;
-        }
+        hitUniverses.clear();
         return ret;
     }
 
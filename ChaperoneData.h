@@ -26,7 +26,7 @@
 #define INCLUDED_ChaperoneData_h_GUID_983CDBF6_6DCF_44AC_E261_19EF8436EA23
 
 // Internal Includes
-// - none
+#include "PlayAreaBounds.h"
 
 // Library/third-party includes
 // - none
@@ -52,11 +52,22 @@ namespace vive {
             CalibrationType type = CalibrationType::Standing;
             std::array<double, 3> translation;
             double yaw = 0.;
+            /// The walls set up in Room Setup ("collision_bounds"), or if
+            /// there are none, the edges of the "play_area" rectangle: in
+            /// standing universe coordinates, so empty for a seated-only
+            /// universe.
+            PlayAreaBounds bounds;
         };
 
         explicit ChaperoneData(std::string const &steamConfigDir);
         ~ChaperoneData();
 
+        /// The name of the file the data is loaded from, in the Steam config
+        /// dir.
+        static const char *getDataFileName();
+        /// The full path of the file the data is loaded from.
+        static std::string getDataFilePath(std::string const &steamConfigDir);
+
         using UniverseId = std::uint64_t;
 
         bool valid() const;
@@ -74,11 +85,19 @@ namespace vive {
         /// Note that 0 is a dummy/always invalid universe.
         bool knowUniverseId(UniverseId universe) const;
 
+        /// Combines knowUniverseId and getDataForUniverse in one lookup.
+        /// @return nullptr if we don't have data for this universe ID (always
+        /// the case for 0), otherwise a pointer valid for the life of this
+        /// object.
+        UniverseData const *findUniverse(UniverseId universe) const;
+
         UniverseData getDataForUniverse(UniverseId universe) const;
 
         /// Get the number of known and handled universes;
         std::size_t getNumberOfKnownUniverses() const;
 
+        /// Picks the universe sharing the largest fraction of its and the
+        /// given base stations (the first listed, on a tie).
         /// If it returns 0, it couldn't.
         UniverseId
         guessUniverseIdFromBaseStations(BaseStationSerials const &bases);
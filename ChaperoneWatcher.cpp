@@ -0,0 +1,215 @@
+/** @file
+    @brief Implementation
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "ChaperoneWatcher.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace osvr {
+namespace vive {
+    /// How often to check for changes: either how often to look at the
+    /// file, or how long to wait for inotify events before checking whether
+    /// we've been stopped.
+    static const auto POLL_INTERVAL = std::chrono::milliseconds(1000);
+    static const auto NOTIFY_WAIT_INTERVAL = std::chrono::milliseconds(250);
+    /// How long the file has to go unchanged before it's reloaded, so a
+    /// burst of writes gets one reload, of the finished file.
+    static const auto SETTLE_TIME = std::chrono::milliseconds(500);
+
+    /// @return an inotify descriptor watching the directory (rather than the
+    /// file, so replacing the file by renaming over it is seen too), or -1.
+    static int openNotifications(std::string const &dir) {
+#ifdef __linux__
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        if (inotify_add_watch(fd, dir.c_str(),
+                              IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO |
+                                  IN_CREATE) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+#else
+        (void)dir;
+        return -1;
+#endif
+    }
+
+    /// Size and modification time, for polling.
+    struct FileState {
+        bool exists = false;
+        std::int64_t size = 0;
+        std::int64_t mtime = 0;
+        bool operator!=(FileState const &other) const {
+            return exists != other.exists || size != other.size ||
+                   mtime != other.mtime;
+        }
+    };
+
+    static FileState getFileState(std::string const &fn) {
+        FileState ret;
+        struct stat st;
+        if (stat(fn.c_str(), &st) == 0) {
+            ret.exists = true;
+            ret.size = static_cast<std::int64_t>(st.st_size);
+            ret.mtime = static_cast<std::int64_t>(st.st_mtime);
+        }
+        return ret;
+    }
+
+    ChaperoneWatcher::ChaperoneWatcher(std::string const &steamConfigDir,
+                                       SnapshotPtr initial)
+        : configDir_(steamConfigDir),
+          filePath_(ChaperoneData::getDataFilePath(steamConfigDir)),
+          snapshot_(std::move(initial)),
+          notifyFd_(openNotifications(steamConfigDir)),
+          thread_([this] { threadFunc(); }) {}
+
+    ChaperoneWatcher::~ChaperoneWatcher() {
+        stop();
+#ifdef __linux__
+        if (notifyFd_ >= 0) {
+            close(notifyFd_);
+        }
+#endif
+    }
+
+    void ChaperoneWatcher::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            stoppingFlag_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::string ChaperoneWatcher::getLastFailure() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastFailure_;
+    }
+
+    void ChaperoneWatcher::threadFunc() {
+        using clock = std::chrono::steady_clock;
+        auto lastState = getFileState(filePath_);
+        bool pending = false;
+        auto lastChange = clock::now();
+        bool maybeChanged = false;
+        while (waitForChange(maybeChanged)) {
+            if (!usingNotifications()) {
+                auto state = getFileState(filePath_);
+                maybeChanged = state != lastState;
+                lastState = state;
+            }
+            if (maybeChanged) {
+                /// Wait for it to settle.
+                pending = true;
+                lastChange = clock::now();
+                continue;
+            }
+            if (pending && clock::now() - lastChange >= SETTLE_TIME) {
+                pending = false;
+                reload();
+            }
+        }
+    }
+
+    bool ChaperoneWatcher::waitForChange(bool &maybeChanged) {
+        maybeChanged = false;
+#ifdef __linux__
+        if (usingNotifications()) {
+            pollfd pfd;
+            pfd.fd = notifyFd_;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            auto ret = poll(&pfd, 1, static_cast<int>(
+                                         NOTIFY_WAIT_INTERVAL.count()));
+            if (stoppingFlag_) {
+                return false;
+            }
+            if (ret <= 0) {
+                return true;
+            }
+            /// Drain all the events, checking whether any are about our
+            /// file (or say some were lost).
+            alignas(inotify_event) char buf[4096];
+            auto fileName = ChaperoneData::getDataFileName();
+            while (true) {
+                auto len = read(notifyFd_, buf, sizeof(buf));
+                if (len <= 0) {
+                    break;
+                }
+                for (char *p = buf; p < buf + len;) {
+                    auto event = reinterpret_cast<inotify_event *>(p);
+                    if ((event->mask & IN_Q_OVERFLOW) ||
+                        (event->len > 0 &&
+                         std::strcmp(event->name, fileName) == 0)) {
+                        maybeChanged = true;
+                    }
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            return true;
+        }
+#endif
+        std::unique_lock<std::mutex> lock(mutex_);
+        return !cv_.wait_for(lock, POLL_INTERVAL, [&] { return stopping_; });
+    }
+
+    void ChaperoneWatcher::reload() {
+        auto data = std::make_shared<ChaperoneData>(configDir_);
+        if (!data->valid()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                lastFailure_ = data->getMessage();
+            }
+            failedReloads_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        std::atomic_store(&snapshot_, SnapshotPtr(std::move(data)));
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+
+} // namespace vive
+} // namespace osvr
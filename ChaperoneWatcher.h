@@ -0,0 +1,134 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_ChaperoneWatcher_h_GUID_B3D07E41_9A2C_4F68_8E15_C6A4F0D92B37
+#define INCLUDED_ChaperoneWatcher_h_GUID_B3D07E41_9A2C_4F68_8E15_C6A4F0D92B37
+
+// Internal Includes
+#include "ChaperoneData.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace osvr {
+namespace vive {
+    /// Owns a thread watching the chaperone info file (with inotify on
+    /// Linux, by polling its size and modification time elsewhere or if
+    /// that fails), reloading it after it changes - say, because Room Setup
+    /// was run again - and publishing each one that loads successfully as a
+    /// new snapshot.
+    ///
+    /// Consumers poll generation() (a single atomic load) and only fetch the
+    /// snapshot when it changes. A snapshot isn't touched by this class
+    /// after it's published, so one consumer thread may use it (including
+    /// the non-const guessUniverseIdFromBaseStations) without locking.
+    class ChaperoneWatcher {
+      public:
+        using SnapshotPtr = std::shared_ptr<ChaperoneData>;
+
+        /// Starts the thread right away.
+        /// @param initial The data already loaded from steamConfigDir, if
+        /// any, published as generation 0.
+        ChaperoneWatcher(std::string const &steamConfigDir,
+                         SnapshotPtr initial);
+
+        /// Stops and joins the thread.
+        ~ChaperoneWatcher();
+
+        ChaperoneWatcher(ChaperoneWatcher const &) = delete;
+        ChaperoneWatcher &operator=(ChaperoneWatcher const &) = delete;
+
+        /// Stops the thread (waiting for any reload in progress to finish).
+        /// Safe to call more than once.
+        void stop();
+
+        /// Bumped after each new snapshot is published.
+        std::uint64_t generation() const {
+            return generation_.load(std::memory_order_acquire);
+        }
+
+        /// The latest snapshot: may be null if there was no initial data and
+        /// the file hasn't loaded successfully since.
+        SnapshotPtr snapshot() const { return std::atomic_load(&snapshot_); }
+
+        /// Whether changes are noticed with inotify (rather than polling).
+        bool usingNotifications() const { return notifyFd_ >= 0; }
+
+        /// @name Failed reloads
+        /// The snapshot is left alone when the changed file doesn't load
+        /// (which may just mean it was caught mid-write - another change
+        /// will follow).
+        /// @{
+        std::uint64_t getFailedReloadCount() const {
+            return failedReloads_.load(std::memory_order_acquire);
+        }
+        /// The messages from the most recent failed reload.
+        std::string getLastFailure() const;
+        /// @}
+
+      private:
+        void threadFunc();
+        /// Waits (up to the poll interval, or until stopped) for something
+        /// that might be a change to the file.
+        /// @return false if stopping.
+        bool waitForChange(bool &maybeChanged);
+        void reload();
+
+        const std::string configDir_;
+        const std::string filePath_;
+
+        SnapshotPtr snapshot_;
+        std::atomic<std::uint64_t> generation_{0};
+        std::atomic<std::uint64_t> failedReloads_{0};
+
+        /// @name Mutex-controlled
+        /// @{
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        std::string lastFailure_;
+        /// @}
+        /// Readable without the mutex, for the inotify wait loop.
+        std::atomic<bool> stoppingFlag_{false};
+
+        /// inotify descriptor watching configDir_, or -1 if polling.
+        const int notifyFd_;
+
+        /// Last, so everything else is set up before it starts.
+        std::thread thread_;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_ChaperoneWatcher_h_GUID_B3D07E41_9A2C_4F68_8E15_C6A4F0D92B37
@@ -0,0 +1,323 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_ClockOffsetEstimator_h_GUID_4F1A8C63_B27E_4D09_95C4_E6D03B7A2F81
+#define INCLUDED_ClockOffsetEstimator_h_GUID_4F1A8C63_B27E_4D09_95C4_E6D03B7A2F81
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace osvr {
+namespace vive {
+    namespace detail {
+        /// How far (in periods) a sample may come in ahead of the line and
+        /// still be given that slot.
+        static const double EARLY_SLOTS = 0.25;
+        /// Samples further below the line than this (in periods) don't fit.
+        static const double MISFIT_SLOTS = 1. / 16;
+        /// A bucket whose samples sit further above the line than this on
+        /// average (in periods) isn't from a periodic stream: the line's
+        /// only fitting the stragglers that happened to land on it.
+        static const double MAX_JITTER_SLOTS = 0.25;
+    } // namespace detail
+
+    /// Online estimator turning one device's jittery pose timestamps (host
+    /// receive time plus the driver's poseTimeOffset) into smooth ones.
+    ///
+    /// The device samples on its own crystal at a fixed period, so the true
+    /// sample times lie on a line: t(n) = offset + period * n, where n counts
+    /// samples and period absorbs the drift between the device and host
+    /// clocks. Delivery jitter only ever makes a sample look later, so - as
+    /// in NTP's clock filter - the line is fit to the minimum of each bucket
+    /// of samples rather than to all of them: a least-squares fit over the
+    /// last NUM_BUCKETS minima.
+    ///
+    /// Until the line has been found and then fit a bucket of samples, or if
+    /// the stream turns out not to be periodic (or stalls), the timestamps
+    /// are passed through untouched.
+    /// Everything is in fastClockNs() nanoseconds. Not thread-safe: one per
+    /// device, used from one thread.
+    class ClockOffsetEstimator {
+      public:
+        /// Samples per bucket (so per minimum fed to the fit).
+        static const std::size_t BUCKET_SAMPLES = 32;
+        /// Bucket minima kept for the fit.
+        static const std::size_t NUM_BUCKETS = 16;
+        /// A longer silence than this starts over.
+        static const std::int64_t MAX_GAP_NS = 250000000;
+        /// More misfits than this in a bucket and the stream isn't periodic.
+        static const std::size_t MAX_BUCKET_MISFITS = BUCKET_SAMPLES / 8;
+
+        /// @param receivedNs When the sample arrived at the host.
+        /// @param sampleNs When the driver says it was sampled.
+        /// @return the filtered sample time.
+        std::int64_t update(std::int64_t receivedNs, std::int64_t sampleNs) {
+            if (started_ && receivedNs - lastReceivedNs_ > MAX_GAP_NS) {
+                reset();
+            }
+            lastReceivedNs_ = receivedNs;
+            if (!started_) {
+                start(sampleNs);
+                return sampleNs;
+            }
+            auto c = static_cast<double>(sampleNs - baseNs_);
+            if (!fitting_) {
+                acquire(c);
+                return sampleNs;
+            }
+
+            /// Which sample is this? Jitter only makes samples late, so it's
+            /// the last slot at or before this time - give or take a little
+            /// error in the line. (Never an earlier one than last time,
+            /// though: a sample more than a period late takes the next one's
+            /// slot, and the next one shares it.)
+            auto slot = static_cast<long long>(
+                std::floor((c - intercept_) / period_ + detail::EARLY_SLOTS));
+            n_ = std::max(n_, slot);
+            auto fitted = lineAt(n_);
+            trackBucket(c - fitted, c,
+                        static_cast<double>(receivedNs - baseNs_));
+            if (!locked_) {
+                /// Still on probation, or not periodic after all.
+                return sampleNs;
+            }
+            /// A sample below the line is better than the line.
+            auto ret = std::min(fitted, c);
+            return baseNs_ + static_cast<std::int64_t>(std::llround(ret));
+        }
+
+        /// Whether timestamps are being filtered (rather than passed
+        /// through).
+        bool locked() const { return locked_; }
+
+        /// Mean time from (filtered) sample to host receipt, over the last
+        /// full bucket - 0 until locked.
+        std::int64_t latencyNs() const { return latencyNs_; }
+
+        /// Mean distance of the raw timestamps above the fitted line, over
+        /// the last full bucket: the jitter being removed.
+        std::int64_t jitterNs() const { return jitterNs_; }
+
+        /// Current estimate of the sample period in host nanoseconds.
+        double periodNs() const { return period_; }
+
+        void reset() { *this = ClockOffsetEstimator{}; }
+
+      private:
+        struct Point {
+            double n;
+            double t;
+        };
+
+        double lineAt(long long n) const {
+            return intercept_ + period_ * static_cast<double>(n);
+        }
+
+        void start(std::int64_t sampleNs) {
+            started_ = true;
+            baseNs_ = sampleNs;
+            acquired_[0] = 0.;
+            numAcquired_ = 1;
+        }
+
+        /// Starts over from the sample at c (relative to the current base),
+        /// passing through meanwhile.
+        void restart(double c) {
+            auto base = baseNs_;
+            reset();
+            start(base + static_cast<std::int64_t>(c));
+        }
+
+        /// Collects a bucket's worth of samples, then numbers them using the
+        /// median interval (robust to skipped samples and jitter), and seeds
+        /// the fit with the minimum of each half - the median alone isn't
+        /// nearly precise enough to extrapolate from.
+        void acquire(double c) {
+            acquired_[numAcquired_++] = c;
+            if (numAcquired_ < acquired_.size()) {
+                return;
+            }
+            std::array<double, BUCKET_SAMPLES - 1> intervals;
+            for (std::size_t i = 1; i < acquired_.size(); ++i) {
+                intervals[i - 1] = acquired_[i] - acquired_[i - 1];
+            }
+            auto mid = intervals.begin() + intervals.size() / 2;
+            std::nth_element(intervals.begin(), mid, intervals.end());
+            if (!(*mid > 0)) {
+                start(baseNs_ + static_cast<std::int64_t>(c));
+                return;
+            }
+            period_ = *mid;
+            n_ = 0;
+            for (std::size_t half = 0; half < 2; ++half) {
+                auto begin = half * acquired_.size() / 2;
+                auto end = begin + acquired_.size() / 2;
+                Point best = {0., 0.};
+                for (auto i = begin; i < end; ++i) {
+                    if (i > 0) {
+                        auto steps = std::llround(
+                            (acquired_[i] - acquired_[i - 1]) / period_);
+                        n_ += std::max<long long>(1, steps);
+                    }
+                    auto n = static_cast<double>(n_);
+                    auto offset = acquired_[i] - period_ * n;
+                    if (i == begin || offset < best.t - period_ * best.n) {
+                        best = Point{n, acquired_[i]};
+                    }
+                }
+                minima_[half] = best;
+            }
+            nextMinimum_ = numMinima_ = 2;
+            fit();
+            fitting_ = true;
+            newBucket();
+        }
+
+        void newBucket() {
+            bucketCount_ = 0;
+            haveBucketMin_ = false;
+            bucketMinResidual_ = 0.;
+            bucketResidualSum_ = 0.;
+            bucketLatencySum_ = 0.;
+            bucketMisfits_ = 0;
+        }
+
+        void trackBucket(double residual, double c, double received) {
+            if (residual < -detail::MISFIT_SLOTS * period_) {
+                /// Most likely so late it got the next slot: useless for
+                /// finding the line - but if it happens too often, the
+                /// stream isn't periodic (or the period estimate is bad), so
+                /// start over, passing through meanwhile.
+                if (++bucketMisfits_ > MAX_BUCKET_MISFITS) {
+                    restart(c);
+                    return;
+                }
+            } else if (!haveBucketMin_ || residual < bucketMinResidual_) {
+                haveBucketMin_ = true;
+                bucketMinResidual_ = residual;
+                bucketMin_ = Point{static_cast<double>(n_), c};
+            }
+            bucketResidualSum_ += residual;
+            bucketLatencySum_ += received - std::min(lineAt(n_), c);
+            if (++bucketCount_ < BUCKET_SAMPLES) {
+                return;
+            }
+            auto jitter =
+                bucketResidualSum_ / bucketCount_ - bucketMinResidual_;
+            if (jitter > detail::MAX_JITTER_SLOTS * period_) {
+                /// Not periodic after all.
+                restart(c);
+                return;
+            }
+            /// A whole bucket fit: done with probation, if we weren't.
+            locked_ = true;
+            jitterNs_ = static_cast<std::int64_t>(jitter);
+            latencyNs_ =
+                static_cast<std::int64_t>(bucketLatencySum_ / bucketCount_);
+            minima_[nextMinimum_] = bucketMin_;
+            nextMinimum_ = (nextMinimum_ + 1) % NUM_BUCKETS;
+            /// (Not std::min, which would take NUM_BUCKETS by reference - and
+            /// it has no out-of-class definition.)
+            numMinima_ =
+                numMinima_ + 1 < NUM_BUCKETS ? numMinima_ + 1 : NUM_BUCKETS;
+            fit();
+            newBucket();
+        }
+
+        /// Least-squares line through the bucket minima.
+        void fit() {
+            double meanN = 0, meanT = 0;
+            for (std::size_t i = 0; i < numMinima_; ++i) {
+                meanN += minima_[i].n;
+                meanT += minima_[i].t;
+            }
+            meanN /= numMinima_;
+            meanT /= numMinima_;
+            double cov = 0, var = 0;
+            for (std::size_t i = 0; i < numMinima_; ++i) {
+                auto dn = minima_[i].n - meanN;
+                cov += dn * (minima_[i].t - meanT);
+                var += dn * dn;
+            }
+            if (var > 0 && cov > 0) {
+                period_ = cov / var;
+            }
+            intercept_ = meanT - period_ * meanN;
+        }
+
+        bool started_ = false;
+        /// Whether there's a line - it has to fit a bucket's worth of samples
+        /// before it's used.
+        bool fitting_ = false;
+        bool locked_ = false;
+        /// Times are kept as doubles relative to this, for precision.
+        std::int64_t baseNs_ = 0;
+        std::int64_t lastReceivedNs_ = 0;
+
+        /// @name Acquiring
+        /// @{
+        std::array<double, BUCKET_SAMPLES> acquired_;
+        std::size_t numAcquired_ = 0;
+        /// @}
+
+        /// @name The line
+        /// @{
+        double period_ = 0.;
+        double intercept_ = 0.;
+        long long n_ = 0;
+        /// @}
+
+        /// @name Current bucket
+        /// @{
+        std::size_t bucketCount_ = 0;
+        bool haveBucketMin_ = false;
+        double bucketMinResidual_ = 0.;
+        Point bucketMin_ = {0., 0.};
+        double bucketResidualSum_ = 0.;
+        double bucketLatencySum_ = 0.;
+        std::size_t bucketMisfits_ = 0;
+        /// @}
+
+        std::array<Point, NUM_BUCKETS> minima_;
+        std::size_t nextMinimum_ = 0;
+        std::size_t numMinima_ = 0;
+
+        std::int64_t latencyNs_ = 0;
+        std::int64_t jitterNs_ = 0;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_ClockOffsetEstimator_h_GUID_4F1A8C63_B27E_4D09_95C4_E6D03B7A2F81
@@ -0,0 +1,115 @@
+/** @file
+    @brief Implementation
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "DriverHostConfig.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+namespace osvr {
+namespace vive {
+
+    static void loadSensorClassConfig(Json::Value const &params,
+                                      const char *key,
+                                      SensorClassConfig &config) {
+        auto const &obj = params[key];
+        if (!obj.isObject()) {
+            return;
+        }
+        config.reportVelocity =
+            obj.get("reportVelocity", config.reportVelocity).asBool();
+        config.reportAcceleration =
+            obj.get("reportAcceleration", config.reportAcceleration).asBool();
+        config.predictionMs = std::max(
+            0., obj.get("predictionMs", config.predictionMs).asDouble());
+    }
+
+    static void loadQueueConfig(Json::Value const &queues, const char *key,
+                                QueueConfig &config) {
+        auto const &obj = queues[key];
+        if (!obj.isObject()) {
+            return;
+        }
+        config.capacity = static_cast<std::size_t>(std::max(
+            0, obj.get("capacity", static_cast<int>(config.capacity))
+                   .asInt()));
+        parseQueueOverflowPolicy(
+            obj.get("overflow", toString(config.overflow)).asString(),
+            config.overflow);
+    }
+
+    void loadDriverHostConfig(Json::Value const &params,
+                              DriverHostConfig &config) {
+        if (!params.isObject()) {
+            return;
+        }
+        config.coalescePoses =
+            params.get("coalescePoses", config.coalescePoses).asBool();
+        config.runFrameRateHz = std::max(
+            0., params.get("runFrameRateHz", config.runFrameRateHz).asDouble());
+        config.filterPoseTimestamps =
+            params.get("filterPoseTimestamps", config.filterPoseTimestamps)
+                .asBool();
+        config.sharedPoses =
+            params.get("sharedPoses", config.sharedPoses).asString();
+        config.reloadChaperone =
+            params.get("reloadChaperone", config.reloadChaperone).asBool();
+        config.reportBoundaryDistance =
+            params.get("reportBoundaryDistance", config.reportBoundaryDistance)
+                .asBool();
+        config.analogDeadband = std::max(
+            0., params.get("analogDeadband", config.analogDeadband).asDouble());
+        auto const &channels = params["analogChannelDeadbands"];
+        if (channels.isObject()) {
+            for (auto const &name : channels.getMemberNames()) {
+                char *end = nullptr;
+                auto channel = std::strtoul(name.c_str(), &end, 10);
+                if (end == name.c_str() || *end != '\0') {
+                    /// Not a channel number.
+                    continue;
+                }
+                config.analogChannelDeadbands[channel] =
+                    std::max(0., channels[name].asDouble());
+            }
+        }
+        auto const &queues = params["queues"];
+        if (queues.isObject()) {
+            loadQueueConfig(queues, "tracking", config.trackingQueue);
+            loadQueueConfig(queues, "button", config.buttonQueue);
+            loadQueueConfig(queues, "analog", config.analogQueue);
+        }
+        loadSensorClassConfig(params, "hmd", config.hmd);
+        loadSensorClassConfig(params, "controllers", config.controllers);
+        loadSensorClassConfig(params, "trackers", config.trackers);
+        loadSensorClassConfig(params, "baseStations", config.baseStations);
+    }
+
+} // namespace vive
+} // namespace osvr
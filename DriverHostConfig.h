@@ -0,0 +1,132 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_DriverHostConfig_h_GUID_52D8B1E6_0C7A_4F3B_9E25_A8F4D61C37B2
+#define INCLUDED_DriverHostConfig_h_GUID_52D8B1E6_0C7A_4F3B_9E25_A8F4D61C37B2
+
+// Internal Includes
+#include "QueueOverflowPolicy.h"
+
+// Library/third-party includes
+#include <json/value.h>
+
+// Standard includes
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace osvr {
+namespace vive {
+    /// Options that can be set separately for each class of tracked device.
+    struct SensorClassConfig {
+        /// Send linear and angular velocity along with each pose.
+        bool reportVelocity = false;
+        /// Send linear and angular acceleration along with each pose.
+        bool reportAcceleration = false;
+        /// If positive, poses are extrapolated (using the driver's
+        /// velocities) to this many milliseconds past the time they're sent.
+        double predictionMs = 0.;
+    };
+
+    /// Options for ViveDriverHost. The defaults match the behavior when no
+    /// configuration is given at all; they can be changed through the
+    /// "params" object of a "com_osvr_Vive"/"ViveConfig" driver entry in the
+    /// server config file.
+    struct DriverHostConfig {
+        /// If true, only the newest pose per sensor is kept between update()
+        /// calls, and the stale ones are counted as dropped.
+        bool coalescePoses = false;
+
+        /// If positive, a dedicated thread calls the SteamVR driver's
+        /// RunFrame at this rate (Hz), instead of once per update() of the
+        /// OSVR server loop.
+        double runFrameRateHz = 0.;
+
+        /// If true, each device's pose timestamps are smoothed by a
+        /// ClockOffsetEstimator (removing delivery jitter, and estimating the
+        /// transport latency, which gets logged) rather than taken as the
+        /// callback time plus the driver's offset.
+        bool filterPoseTimestamps = false;
+
+        /// If not empty, the name of a POSIX shared memory segment (like
+        /// "/osvr_vive_poses") to publish each sensor's latest pose to, as
+        /// sent to OSVR - for processes on the same machine to read without
+        /// going through VRPN. See ViveSharedPoses.h for the layout.
+        std::string sharedPoses;
+
+        /// If true, the chaperone info file is watched for changes (like
+        /// running Room Setup again), and reloaded without restarting the
+        /// server - the current universe's transform is updated to match.
+        bool reloadChaperone = true;
+
+        /// If true, each tracked sensor's distance (in meters, in the floor
+        /// plane) from the nearest wall of the play area set up in Room
+        /// Setup is reported on analog channel 7 + its sensor number (for
+        /// the first 16 sensors) - the HMD and controllers have
+        /// "boundaryDistance" aliases in the device descriptor.
+        bool reportBoundaryDistance = false;
+
+        /// @name Analog deadband
+        /// A trackpad or trigger value is only sent when it differs from the
+        /// last one sent on that channel by more than the deadband, or when it
+        /// comes to rest at -1, 0 or 1. 0 sends every change.
+        /// @{
+        double analogDeadband = 0.;
+        /// Overrides of analogDeadband by analog channel number, read from
+        /// an object like {"3": 0.02}.
+        std::map<std::uint32_t, double> analogChannelDeadbands;
+        /// @}
+
+        /// @name Report queues
+        /// Between the driver callbacks and update(), each read from a member
+        /// of the same name in a "queues" object, like
+        /// {"capacity": 4096, "overflow": "dropOldest"}. A capacity of 0 is
+        /// unbounded; queues built lock-free through CMake can't be, and
+        /// treat neverDrop as dropNewest.
+        /// @{
+        QueueConfig trackingQueue{4096, QueueOverflowPolicy::DropOldest};
+        QueueConfig buttonQueue{1024, QueueOverflowPolicy::NeverDrop};
+        QueueConfig analogQueue{1024, QueueOverflowPolicy::DropOldest};
+        /// @}
+
+        /// @name Per sensor class
+        /// Each read from an object member of the same name.
+        /// @{
+        SensorClassConfig hmd;
+        SensorClassConfig controllers;
+        /// Vive Trackers (pucks)
+        SensorClassConfig trackers;
+        SensorClassConfig baseStations;
+        /// @}
+    };
+
+    /// Updates the config with any recognized members of the given JSON
+    /// object - members not present keep their current values.
+    void loadDriverHostConfig(Json::Value const &params,
+                              DriverHostConfig &config);
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_DriverHostConfig_h_GUID_52D8B1E6_0C7A_4F3B_9E25_A8F4D61C37B2
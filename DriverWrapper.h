@@ -36,6 +36,7 @@
 #include "GetProvider.h"
 #include "Properties.h"
 #include "Resources.h"
+#include "RunFramePacer.h"
 #include "ServerDriverHost.h"
 #include "Settings.h"
 
@@ -206,7 +207,8 @@ namespace vive {
               chaperone_(std::move(other.chaperone_)),
               loader_(std::move(other.loader_)),
               serverDeviceProvider_(std::move(other.serverDeviceProvider_)),
-              devices_(std::move(other.devices_)) {}
+              devices_(std::move(other.devices_)),
+              runFramePacer_(std::move(other.runFramePacer_)) {}
 #else
         /// Move constructor
         DriverWrapper(DriverWrapper &&other) = default;
@@ -374,6 +376,11 @@ namespace vive {
 
         bool haveChaperoneData() const { return static_cast<bool>(chaperone_); }
         ChaperoneData &chaperone() { return *chaperone_; }
+        /// Shared ownership of the chaperone data, for keeping it (or
+        /// replacing it with a reloaded copy) beyond this object.
+        std::shared_ptr<ChaperoneData> const &shareChaperone() const {
+            return chaperone_;
+        }
 
         /// Set whether all devices should be deactivated on shutdown - defaults
         /// to true, so you might just want to set to false if, for instance,
@@ -382,11 +389,53 @@ namespace vive {
             devices_.disableDeactivateOnShutdown();
         }
 
+        /// Starts a dedicated thread calling RunFrame on the server device
+        /// provider at the given rate, so you no longer need to (and must not)
+        /// call it yourself. The driver's callbacks into the server driver
+        /// host will then arrive on that thread. Does nothing if already
+        /// started.
+        ///
+        /// @return false if the device provider isn't started or the rate is
+        /// not positive.
+        bool startRunFrameThread(double rateHz) {
+            if (runFramePacer_) {
+                return true;
+            }
+            if (!serverDeviceProvider_ || !(rateHz > 0)) {
+                return false;
+            }
+            /// The provider object itself doesn't move if we do, so capture
+            /// that rather than this.
+            auto provider = serverDeviceProvider_.get();
+            runFramePacer_.reset(new RunFramePacer(
+                [provider] { provider->RunFrame(); }, rateHz));
+            return true;
+        }
+
+        bool haveRunFrameThread() const {
+            return static_cast<bool>(runFramePacer_);
+        }
+
+        /// Stops and joins the RunFrame thread, if started. Called by stop()
+        /// too.
+        void stopRunFrameThread() { runFramePacer_.reset(); }
+
+        /// @return timing statistics of the RunFrame thread since the last
+        /// call (all zero if it isn't running).
+        RunFrameStats takeRunFrameStats() {
+            if (!runFramePacer_) {
+                return RunFrameStats{};
+            }
+            return runFramePacer_->takeStats();
+        }
+
         /// Indicate to the system that you're preparing to stop the system.
         ///
-        /// Sets the exiting flag on the server driver host, and if still
-        /// enabled, deactivates all devices.
+        /// Stops the RunFrame thread if any, sets the exiting flag on the
+        /// server driver host, and if still enabled, deactivates all devices.
         void stop() {
+            /// Must be first: no more driver callbacks racing the shutdown.
+            stopRunFrameThread();
             if (haveServerDeviceHost()) {
                 serverDriverHost_->setExiting();
             }
@@ -421,7 +470,7 @@ namespace vive {
         vr::ServerDriverHost *serverDriverHost_;
 
         LocationInfo locations_;
-        std::unique_ptr<ChaperoneData> chaperone_;
+        std::shared_ptr<ChaperoneData> chaperone_;
 
         std::unique_ptr<DriverLoader> loader_;
         ProviderPtr<vr::IServerTrackedDeviceProvider> serverDeviceProvider_;
@@ -432,6 +481,9 @@ namespace vive {
         DeviceHolder devices_;
         NullDriverLog nullDriverLog_;
 
+        /// Only set if startRunFrameThread() was called.
+        std::unique_ptr<RunFramePacer> runFramePacer_;
+
         /// This context pointer is used in calling the
         /// IServerTrackedDeviceProvider.Init
         /// the next three object ptrs are used for context
@@ -0,0 +1,56 @@
+/** @file
+    @brief Implementation
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "FastClock.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace osvr {
+namespace vive {
+#ifdef _WIN32
+    std::int64_t performanceCounterNs() {
+        static const auto frequency = [] {
+            LARGE_INTEGER f;
+            QueryPerformanceFrequency(&f);
+            return f.QuadPart;
+        }();
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        /// Split up to avoid overflowing the multiplication.
+        auto whole = counter.QuadPart / frequency;
+        auto part = counter.QuadPart % frequency;
+        return whole * 1000000000 + part * 1000000000 / frequency;
+    }
+#endif
+} // namespace vive
+} // namespace osvr
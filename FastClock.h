@@ -0,0 +1,112 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_FastClock_h_GUID_E84C2A17_6D3B_4F95_A1C0_3B7E9D52F648
+#define INCLUDED_FastClock_h_GUID_E84C2A17_6D3B_4F95_A1C0_3B7E9D52F648
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+#include <osvr/Util/TimeValue.h>
+
+// Standard includes
+#include <cstdint>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace osvr {
+namespace vive {
+#ifdef _WIN32
+    /// The performance counter in nanoseconds - in FastClock.cpp, so
+    /// <windows.h> stays out of everything that includes this header.
+    std::int64_t performanceCounterNs();
+#endif
+
+    /// Monotonic nanoseconds from an arbitrary epoch: cheap enough to call
+    /// from every driver callback (a vDSO call on Linux, no syscall, and no
+    /// normalizing), but only meaningful relative to another reading - use a
+    /// FastClockCalibration to turn readings into OSVR_TimeValue.
+    inline std::int64_t fastClockNs() {
+#ifdef _WIN32
+        return performanceCounterNs();
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+    }
+
+    /// Converts a duration in seconds (like the driver's time offsets) to
+    /// fast clock nanoseconds, truncating.
+    inline std::int64_t secondsToFastClockNs(double seconds) {
+        return static_cast<std::int64_t>(seconds * 1e9);
+    }
+
+    /// Pairs a fast clock reading with the OSVR clock, so readings taken near
+    /// that time can be converted. Recalibrated once per batch of reports
+    /// (so the OSVR clock being adjusted is picked up quickly), rather than
+    /// reading the OSVR clock per report.
+    class FastClockCalibration {
+      public:
+        /// Reads both clocks.
+        void calibrate() {
+            baseTime_ = osvr::util::time::getNow();
+            baseNs_ = fastClockNs();
+        }
+
+        /// The OSVR time as of the last calibrate().
+        OSVR_TimeValue const &baseTime() const { return baseTime_; }
+        /// The fast clock reading as of the last calibrate().
+        std::int64_t baseNs() const { return baseNs_; }
+
+        OSVR_TimeValue toTimeValue(std::int64_t ns) const {
+            auto diff = ns - baseNs_;
+            OSVR_TimeValue ret = baseTime_;
+            ret.seconds += static_cast<OSVR_TimeValue_Seconds>(
+                diff / 1000000000);
+            ret.microseconds += static_cast<OSVR_TimeValue_Microseconds>(
+                (diff % 1000000000) / 1000);
+            /// At most one second off in either direction now.
+            if (ret.microseconds < 0) {
+                ret.microseconds += 1000000;
+                ret.seconds -= 1;
+            } else if (ret.microseconds >= 1000000) {
+                ret.microseconds -= 1000000;
+                ret.seconds += 1;
+            }
+            return ret;
+        }
+
+      private:
+        OSVR_TimeValue baseTime_ = {0, 0};
+        std::int64_t baseNs_ = 0;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_FastClock_h_GUID_E84C2A17_6D3B_4F95_A1C0_3B7E9D52F648
@@ -33,11 +33,17 @@
 #include <osvr/Util/PlatformConfig.h>
 
 // Standard includes
+#include <cstdint>
 #include <fstream> // std::ifstream
 #include <iostream>
 #include <limits.h>
+#include <map>
+#include <mutex>
 #include <vector>
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #if defined(OSVR_USING_FILESYSTEM_HEADER)
 #include <filesystem>
 #elif defined(OSVR_USING_BOOST_FILESYSTEM)
@@ -119,36 +125,29 @@ namespace vive {
     }
 
 #if defined(OSVR_WINDOWS)
-    inline Json::Value getPathConfig() {
+    /// @return the path of openvrpaths.vrpath, or an empty string if we
+    /// can't even work out where it should be.
+    inline std::string getPathConfigFilePath() {
         PWSTR outString = nullptr;
-        Json::Value ret;
         // It's OK to use Vista+ stuff here, since openvr_api.dll uses Vista+
         // stuff too.
         auto hr =
             SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &outString);
         if (!SUCCEEDED(hr)) {
             std::cerr << "Could not get local app data directory!" << std::endl;
-            return ret;
+            return std::string{};
         }
         // Free the string returned when we're all done.
-        /// @todo Shouldn't this be in a "finally()" call?
-        auto freeString = [&] { CoTaskMemFree(outString); };
+        auto freeString = finally([&] { CoTaskMemFree(outString); });
         // Build the path to the file.
         auto vrPaths =
             wpath(outString) / wpath(L"openvr") / wpath(L"openvrpaths.vrpath");
-        std::ifstream is(vrPaths.string());
-        if (!is) {
-            std::wcerr << L"Could not open file containing path configuration "
-                          L"- have you run SteamVR yet? "
-                       << vrPaths << L"\n";
-            return ret;
-        }
-        parsePathConfigFile(is, ret);
-        return ret;
+        return vrPaths.string();
     }
 
 #elif defined(OSVR_MACOSX) || defined(OSVR_LINUX)
-    inline Json::Value getPathConfig() {
+    /// @return the path of openvrpaths.vrpath
+    inline std::string getPathConfigFilePath() {
         auto home = std::getenv("HOME");
         path homePath =
             (nullptr == home
@@ -156,9 +155,16 @@ namespace vive {
                  /*that's weird, should have been in environment...*/
                  : path{home});
         auto vrPaths = homePath / path{".openvr"} / path{"openvrpaths.vrpath"};
+        return vrPaths.string();
+    }
+#endif
 
-        std::ifstream is(vrPaths.string());
+    inline Json::Value getPathConfig(std::string const &vrPaths) {
         Json::Value ret;
+        if (vrPaths.empty()) {
+            return ret;
+        }
+        std::ifstream is(vrPaths);
         if (!is) {
             std::cerr << "Could not open file containing path configuration "
                          "- have you run SteamVR yet? "
@@ -168,7 +174,99 @@ namespace vive {
         parsePathConfigFile(is, ret);
         return ret;
     }
+
+    /// What identifies a version of the path config file without reading
+    /// it. The modification time alone has only whole seconds on some
+    /// platforms - and a rewrite within the same second, to the same size,
+    /// is likely - so the sub-second part is kept where there is one, along
+    /// with the inode (a replacement renamed into place gets a new one) and
+    /// the status change time.
+    struct PathConfigStamp {
+        bool exists = false;
+        std::int64_t size = 0;
+        std::int64_t mtime = 0;
+        std::int64_t mtimeNs = 0;
+        std::int64_t ctime = 0;
+        std::int64_t ctimeNs = 0;
+        std::uint64_t inode = 0;
+        bool operator==(PathConfigStamp const &other) const {
+            return exists == other.exists && size == other.size &&
+                   mtime == other.mtime && mtimeNs == other.mtimeNs &&
+                   ctime == other.ctime && ctimeNs == other.ctimeNs &&
+                   inode == other.inode;
+        }
+    };
+
+    inline PathConfigStamp getPathConfigStamp(std::string const &vrPaths) {
+        PathConfigStamp ret;
+        struct stat st;
+        if (!vrPaths.empty() && stat(vrPaths.c_str(), &st) == 0) {
+            ret.exists = true;
+            ret.size = static_cast<std::int64_t>(st.st_size);
+            ret.mtime = static_cast<std::int64_t>(st.st_mtime);
+            ret.ctime = static_cast<std::int64_t>(st.st_ctime);
+            /// Always 0 on Windows, which is fine: it just doesn't help.
+            ret.inode = static_cast<std::uint64_t>(st.st_ino);
+#if defined(OSVR_MACOSX)
+            ret.mtimeNs = static_cast<std::int64_t>(st.st_mtimespec.tv_nsec);
+            ret.ctimeNs = static_cast<std::int64_t>(st.st_ctimespec.tv_nsec);
+#elif defined(OSVR_LINUX)
+            ret.mtimeNs = static_cast<std::int64_t>(st.st_mtim.tv_nsec);
+            ret.ctimeNs = static_cast<std::int64_t>(st.st_ctim.tv_nsec);
 #endif
+        }
+        return ret;
+    }
+
+    /// The parsed path config, and everything looked up from it, shared
+    /// process-wide: the DriverWrapper, vr::Properties and tool lookups all
+    /// want the same answers during startup, and each fresh lookup means
+    /// reading and parsing the file and checking several paths exist.
+    ///
+    /// Checking the file's stamp (one stat) is all a lookup costs until the
+    /// file changes - which is how installing, moving or re-registering
+    /// SteamVR shows up.
+    struct PathConfigCache {
+        std::mutex mutex;
+        /// @name Mutex-controlled
+        /// @{
+        /// Where the file is - worked out once.
+        std::string vrPaths;
+        bool loaded = false;
+        PathConfigStamp stamp;
+        Json::Value json;
+        std::map<std::string, LocationInfo> locations;
+        std::map<std::string, DriverLocationInfo> drivers;
+        /// Keyed by tool name and SteamVR root, separated by a NUL.
+        std::map<std::string, std::string> tools;
+        /// @}
+    };
+
+    /// Namespace scope rather than a function-local static: those aren't
+    /// thread-safe to initialize on VS2013.
+    static PathConfigCache g_pathConfigCache;
+
+    /// Brings the cache up to date with the file, emptying it if the file
+    /// has changed. Call with the mutex held.
+    inline PathConfigCache &refreshPathConfigCache() {
+        auto &cache = g_pathConfigCache;
+        if (!cache.loaded) {
+            cache.vrPaths = getPathConfigFilePath();
+        }
+        /// Before reading it, so a change made while it's being read gets
+        /// picked up next time.
+        auto stamp = getPathConfigStamp(cache.vrPaths);
+        if (cache.loaded && stamp == cache.stamp) {
+            return cache;
+        }
+        cache.stamp = stamp;
+        cache.json = getPathConfig(cache.vrPaths);
+        cache.locations.clear();
+        cache.drivers.clear();
+        cache.tools.clear();
+        cache.loaded = true;
+        return cache;
+    }
 
     inline std::vector<std::string> getSteamVRRoots(Json::Value const &json) {
         std::vector<std::string> ret;
@@ -182,10 +280,6 @@ namespace vive {
         return ret;
     }
 
-    inline std::vector<std::string> getSteamVRRoots() {
-        return getSteamVRRoots(getPathConfig());
-    }
-
     inline void computeDriverRootAndFilePath(DriverLocationInfo &info,
                                              std::string const &driver) {
         auto p = path{info.steamVrRoot};
@@ -236,16 +330,25 @@ namespace vive {
     }
 
     DriverLocationInfo findDriver(std::string const &driver) {
-        return findDriver(getPathConfig(), driver);
+        std::lock_guard<std::mutex> lock(g_pathConfigCache.mutex);
+        auto &cache = refreshPathConfigCache();
+        auto it = cache.drivers.find(driver);
+        if (it == end(cache.drivers)) {
+            it = cache.drivers.emplace(driver, findDriver(cache.json, driver))
+                     .first;
+        }
+        return it->second;
     }
 
-    std::string getToolLocation(std::string const &toolName,
-                                std::string const &steamVrRoot) {
+    /// Underlying implementation - hand it the preloaded json.
+    inline std::string getToolLocation(Json::Value const &json,
+                                       std::string const &toolName,
+                                       std::string const &steamVrRoot) {
         std::vector<std::string> searchPath;
         if (!steamVrRoot.empty()) {
             searchPath = {steamVrRoot};
         } else {
-            searchPath = getSteamVRRoots();
+            searchPath = getSteamVRRoots(json);
         }
 
         for (auto &root : searchPath) {
@@ -260,6 +363,21 @@ namespace vive {
         return std::string{};
     }
 
+    std::string getToolLocation(std::string const &toolName,
+                                std::string const &steamVrRoot) {
+        std::lock_guard<std::mutex> lock(g_pathConfigCache.mutex);
+        auto &cache = refreshPathConfigCache();
+        auto key = toolName + '\0' + steamVrRoot;
+        auto it = cache.tools.find(key);
+        if (it == end(cache.tools)) {
+            it = cache.tools
+                     .emplace(key, getToolLocation(cache.json, toolName,
+                                                   steamVrRoot))
+                     .first;
+        }
+        return it->second;
+    }
+
     /// Underlying implementation - hand it the preloaded json.
     inline ConfigDirs findConfigDirs(Json::Value const &json,
                                      std::string const &driver) {
@@ -284,12 +402,13 @@ namespace vive {
 #if 0
     ConfigDirs findConfigDirs(std::string const & /*steamVrRoot*/,
                               std::string const &driver) {
-        return findConfigDirs(getPathConfig(), driver);
+        return findConfigDirs(getPathConfig(getPathConfigFilePath()), driver);
     }
 #endif
 
-    LocationInfo findLocationInfoForDriver(std::string const &driver) {
-        auto json = getPathConfig();
+    /// Underlying implementation - hand it the preloaded json.
+    inline LocationInfo findLocationInfoForDriver(Json::Value const &json,
+                                                  std::string const &driver) {
         LocationInfo ret;
 
         auto config = findConfigDirs(json, driver);
@@ -310,5 +429,18 @@ namespace vive {
         return ret;
     }
 
+    LocationInfo findLocationInfoForDriver(std::string const &driver) {
+        std::lock_guard<std::mutex> lock(g_pathConfigCache.mutex);
+        auto &cache = refreshPathConfigCache();
+        auto it = cache.locations.find(driver);
+        if (it == end(cache.locations)) {
+            it = cache.locations
+                     .emplace(driver,
+                              findLocationInfoForDriver(cache.json, driver))
+                     .first;
+        }
+        return it->second;
+    }
+
 } // namespace vive
 } // namespace osvr
@@ -67,6 +67,10 @@ namespace vive {
     };
 
     /// Get the location information on the given driver, including config info.
+    ///
+    /// This and the other lookups below (except findConfigDirs) are
+    /// memoized process-wide. The results are kept until the
+    /// openvrpaths.vrpath file changes, so repeat calls are cheap.
     LocationInfo findLocationInfoForDriver(
         std::string const &driver = std::string(DRIVER_NAME));
 
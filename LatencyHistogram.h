@@ -0,0 +1,153 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_LatencyHistogram_h_GUID_5E2A9C14_7B3D_4F60_8A1E_C4D7F2B90E53
+#define INCLUDED_LatencyHistogram_h_GUID_5E2A9C14_7B3D_4F60_8A1E_C4D7F2B90E53
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace osvr {
+namespace vive {
+    /// Monotonic nanoseconds for latency measurements - only differences
+    /// are meaningful.
+    inline std::int64_t latencyClockNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// A fixed-size histogram of durations in nanoseconds, with buckets laid
+    /// out like HdrHistogram: each power of two is split into
+    /// SUB_BUCKETS linear buckets, so any value is recorded to within about
+    /// 6%, from 1 ns up to about 18 minutes. Recording is a handful of
+    /// integer operations and one increment - no allocation, no locking (so
+    /// one thread only).
+    class LatencyHistogram {
+      public:
+        static const int SUB_BUCKET_BITS = 4;
+        static const std::int64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        /// Values of 2^MAX_EXPONENT ns and up all land in the last bucket.
+        static const int MAX_EXPONENT = 40;
+        static const std::size_t NUM_BUCKETS =
+            (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        void record(std::int64_t ns) {
+            if (ns < 0) {
+                ns = 0;
+            }
+            ++buckets_[bucketFor(ns)];
+            ++count_;
+            if (ns > max_) {
+                max_ = ns;
+            }
+        }
+
+        std::uint64_t count() const { return count_; }
+        std::int64_t max() const { return max_; }
+
+        /// @return the (upper bound of the bucket of the) value at or below
+        /// which the given fraction (0 to 1) of the recorded values fall, or
+        /// 0 if nothing has been recorded.
+        std::int64_t percentile(double fraction) const {
+            if (0 == count_) {
+                return 0;
+            }
+            auto threshold = static_cast<std::uint64_t>(fraction * count_);
+            if (threshold < 1) {
+                threshold = 1;
+            }
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+                seen += buckets_[i];
+                if (seen >= threshold) {
+                    if (i + 1 == NUM_BUCKETS) {
+                        /// Unbounded above.
+                        return max_;
+                    }
+                    auto upper = bucketLowerBound(i + 1) - 1;
+                    return upper < max_ ? upper : max_;
+                }
+            }
+            return max_;
+        }
+
+        void reset() {
+            buckets_.fill(0);
+            count_ = 0;
+            max_ = 0;
+        }
+
+      private:
+        static std::size_t bucketFor(std::int64_t ns) {
+            if (ns < SUB_BUCKETS) {
+                return static_cast<std::size_t>(ns);
+            }
+            /// Find the highest set bit with a binary search - portable, and
+            /// only six steps.
+            int exponent = 0;
+            auto v = static_cast<std::uint64_t>(ns);
+            for (int step = 32; step > 0; step /= 2) {
+                if (v >> step) {
+                    v >>= step;
+                    exponent += step;
+                }
+            }
+            if (exponent >= MAX_EXPONENT) {
+                return NUM_BUCKETS - 1;
+            }
+            auto shift = exponent - SUB_BUCKET_BITS;
+            auto sub = (ns >> shift) & (SUB_BUCKETS - 1);
+            return static_cast<std::size_t>(
+                (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub);
+        }
+
+        static std::int64_t bucketLowerBound(std::size_t bucket) {
+            auto i = static_cast<std::int64_t>(bucket);
+            if (i < SUB_BUCKETS) {
+                return i;
+            }
+            auto shift = i / SUB_BUCKETS - 1;
+            auto sub = i % SUB_BUCKETS;
+            return (SUB_BUCKETS + sub) << shift;
+        }
+
+        std::array<std::uint64_t, NUM_BUCKETS> buckets_ = {{}};
+        std::uint64_t count_ = 0;
+        std::int64_t max_ = 0;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_LatencyHistogram_h_GUID_5E2A9C14_7B3D_4F60_8A1E_C4D7F2B90E53
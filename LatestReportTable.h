@@ -0,0 +1,185 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_LatestReportTable_h_GUID_7A0E2B94_1F63_4C58_A2D9_6B3C8E41F5D7
+#define INCLUDED_LatestReportTable_h_GUID_7A0E2B94_1F63_4C58_A2D9_6B3C8E41F5D7
+
+// Internal Includes
+#include "VerifyLocked.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osvr {
+namespace vive {
+
+    /// A "latest wins" alternative to QuickProcessingDeque: instead of a
+    /// queue, there's a (mutex-controlled) slot per index (sensor), and
+    /// submitting replaces whatever that slot held that the main thread hadn't
+    /// grabbed yet. Replaced items are counted per index rather than silently
+    /// vanishing.
+    template <typename T, typename LockType = std::lock_guard<std::mutex>>
+    class LatestReportTable {
+      public:
+        using value_type = T;
+        using vector_type = std::vector<T>;
+        using lock_type = LockType;
+        using count_vector_type = std::vector<std::uint64_t>;
+
+        /// Call from the async thread you can't control
+        /// Must hold the lock.
+        /// @return true if this replaced a not-yet-grabbed item.
+        bool submitNew(std::size_t idx, value_type const &v, lock_type &lock) {
+            if (!verifyLocked<lock_type>(lock)) {
+                return false;
+            }
+            auto &slot = getSlot(idx);
+            auto replaced = slot.occupied;
+            slot.value = v;
+            markOccupied(slot);
+            return replaced;
+        }
+
+        /// @overload
+        bool submitNew(std::size_t idx, value_type &&v, lock_type &lock) {
+            if (!verifyLocked<lock_type>(lock)) {
+                return false;
+            }
+            auto &slot = getSlot(idx);
+            auto replaced = slot.occupied;
+            slot.value = std::move(v);
+            markOccupied(slot);
+            return replaced;
+        }
+
+        /// Empties all occupied slots, in index order, into the given functor
+        /// (taking a value_type &&). Replacement counts are kept. Useful to
+        /// flush pending items into an ordered queue ahead of some marker.
+        /// Must hold the lock.
+        template <typename F> void drainInto(lock_type &lock, F &&f) {
+            if (!verifyLocked<lock_type>(lock)) {
+                return;
+            }
+            for (auto &slot : slots_) {
+                if (slot.occupied) {
+                    slot.occupied = false;
+                    f(std::move(slot.value));
+                }
+            }
+            numOccupied_ = 0;
+        }
+
+        /// Call from the main thread to grab the latest item from each
+        /// occupied slot, in index order, to deal with.
+        /// Must hold the lock.
+        std::size_t grabItems(lock_type &lock) {
+            clearWorkItems();
+            if (!verifyLocked<lock_type>(lock)) {
+                return 0;
+            }
+            if (droppedTotals_.size() < slots_.size()) {
+                droppedTotals_.resize(slots_.size(), 0);
+            }
+            /// The table only grows with the number of sensors, so there's
+            /// nothing to scan if nothing has been submitted.
+            if (0 == numOccupied_ && 0 == numDroppedSinceGrab_) {
+                return 0;
+            }
+            for (std::size_t i = 0, e = slots_.size(); i < e; ++i) {
+                auto &slot = slots_[i];
+                if (slot.occupied) {
+                    slot.occupied = false;
+                    vector_.push_back(std::move(slot.value));
+                }
+                droppedTotals_[i] += slot.dropped;
+                slot.dropped = 0;
+            }
+            numOccupied_ = 0;
+            numDroppedSinceGrab_ = 0;
+            return vector_.size();
+        }
+
+        /// Call from the main thread, after calling grabItems then releasing
+        /// the lock, to get access to the items you just grabbed. (Cleared
+        /// automatically every call to grabItems)
+        vector_type const &accessWorkItems() const { return vector_; }
+
+        /// Not necessary, since it's called at the beginning of each grabItems.
+        void clearWorkItems() { vector_.clear(); }
+
+        /// Call from the main thread: total number of items, per index,
+        /// replaced before they could be grabbed - as of the last grabItems.
+        count_vector_type const &getDroppedCounts() const {
+            return droppedTotals_;
+        }
+
+      private:
+        struct Slot {
+            value_type value;
+            bool occupied = false;
+            std::uint64_t dropped = 0;
+        };
+
+        Slot &getSlot(std::size_t idx) {
+            if (!(idx < slots_.size())) {
+                slots_.resize(idx + 1);
+            }
+            return slots_[idx];
+        }
+
+        void markOccupied(Slot &slot) {
+            if (slot.occupied) {
+                ++slot.dropped;
+                ++numDroppedSinceGrab_;
+            } else {
+                slot.occupied = true;
+                ++numOccupied_;
+            }
+        }
+
+        /// @name for mutex-controlled use.
+        /// @{
+        std::vector<Slot> slots_;
+        std::size_t numOccupied_ = 0;
+        std::size_t numDroppedSinceGrab_ = 0;
+        /// @}
+
+        /// @name for use by the main thread.
+        /// @{
+        vector_type vector_;
+        count_vector_type droppedTotals_;
+        /// @}
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_LatestReportTable_h_GUID_7A0E2B94_1F63_4C58_A2D9_6B3C8E41F5D7
@@ -39,8 +39,11 @@
 #include <osvr/Util/TimeValue.h>
 
 // Standard includes
+#include <algorithm>
 #include <array>
-#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
 
 namespace osvr {
 namespace vive {
@@ -54,15 +57,66 @@ namespace vive {
     static const auto BASE_STATIONS_SENSORS = {3, 4};
     static const auto PUCK_SENSOR = 5;
 
-    static const auto NUM_ANALOGS = 7;
-    static const auto NUM_BUTTONS = 14;
-
     /// Analog sensor for the IPD
     static const auto IPD_ANALOG = 0;
+    /// If reportBoundaryDistance is on, sensor n's distance (in meters) from
+    /// the nearest wall of the play area is reported on analog
+    /// BOUNDARY_DISTANCE_ANALOG + n, for the first BOUNDARY_DISTANCE_SENSORS
+    /// sensors.
+    static const OSVR_ChannelCount BOUNDARY_DISTANCE_ANALOG = 7;
+    static const OSVR_ChannelCount BOUNDARY_DISTANCE_SENSORS = 16;
+    /// Boundary distances are only sent when they've moved by more than
+    /// this, in meters.
+    static const auto BOUNDARY_DISTANCE_DEADBAND = 0.005;
+
+    static const auto NUM_ANALOGS =
+        BOUNDARY_DISTANCE_ANALOG + BOUNDARY_DISTANCE_SENSORS;
+    static const auto NUM_BUTTONS = 14;
     static const auto PROX_SENSOR_BUTTON_OFFSET = 1;
 
     static const auto PREFIX = "OSVR-Vive";
 
+    /// Minimum time between log messages summarizing how many stale poses
+    /// were dropped in coalescing mode.
+    static const auto COALESCED_POSE_LOG_INTERVAL = 5.0;
+
+    /// Minimum time between log messages summarizing how many analog reports
+    /// the deadband and coalescing kept from being sent.
+    static const auto ANALOG_SUPPRESSION_LOG_INTERVAL = 30.0;
+
+    /// Time between log messages giving the estimated transport latency, if
+    /// pose timestamps are filtered.
+    static const auto TRANSPORT_LATENCY_LOG_INTERVAL = 30.0;
+
+    /// Minimum time between log messages about report queues reaching a new
+    /// high-water mark.
+    static const auto QUEUE_HIGH_WATER_LOG_INTERVAL = 30.0;
+
+    /// In coalescing mode, each sensor gets this many slots in the latest
+    /// report table: the pose, then its velocity, then its acceleration.
+    static const std::size_t TRACKING_SLOTS_PER_SENSOR = 3;
+    static const std::size_t POSE_SLOT = 0;
+    static const std::size_t VELOCITY_SLOT = 1;
+    static const std::size_t ACCELERATION_SLOT = 2;
+
+    /// Angular rates are expressed as the incremental rotations OSVR wants
+    /// over the interval since the sensor's previous pose - or this long,
+    /// for its first pose, or if the interval is longer (the increment
+    /// should stay a small step).
+    static const auto ANGULAR_INCREMENT_DT = 0.01;
+
+    /// Longest we'll extrapolate a pose, in seconds - a sample that old is
+    /// better sent late than guessed at.
+    static const auto MAX_PREDICTION_INTERVAL = 0.1;
+
+    /// Time between RunFrame thread timing log messages.
+    static const auto RUN_FRAME_STATS_LOG_INTERVAL = 10.0;
+
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+    /// Time between latency percentile log messages.
+    static const auto LATENCY_LOG_INTERVAL = 10.0;
+#endif
+
     /// For the HMD and two controllers
     static const std::array<uint32_t, 3> FIRST_BUTTON_ID = {0, 2, 8};
     static const std::array<uint32_t, 3> FIRST_ANALOG_ID = {0, 1, 4};
@@ -87,45 +141,114 @@ namespace vive {
     static const auto PUCK_KEY = "pucks";
     static const auto SEMANTIC_KEY = "semantic";
 
-    /// Add a util::time::TimeValue and a std::chrono::duration, returning a
-    /// TimeValue again.
-    ///
-    /// Originally from OSVR-Core
-    /// plugins/unifiedvideoinertialtracker/ThreadsafeBodyReporting.cpp but it
-    /// (or something like it) really belongs in a header of its own somewhere
-    template <typename Rep, typename Period>
-    inline util::time::TimeValue
-    operator+(util::time::TimeValue const &tv,
-              std::chrono::duration<Rep, Period> additionalTime) {
-        using namespace std::chrono;
-        using SecondsDuration = duration<OSVR_TimeValue_Seconds>;
-        using USecondsDuration =
-            duration<OSVR_TimeValue_Microseconds, std::micro>;
-        auto ret = tv;
-        auto seconds = duration_cast<SecondsDuration>(additionalTime);
-        ret.seconds += seconds.count();
-        ret.microseconds +=
-            duration_cast<USecondsDuration>(additionalTime - seconds).count();
-        osvrTimeValueNormalize(&ret);
-        return ret;
-    }
-
     /// Single, centralized routine to apply the various event time offsets - so
     /// if we're wrong about the sign to be applied, we only have to fix it in
     /// one place.
     ///
+    /// Works on fastClockNs() readings, in integer nanoseconds, so it's just
+    /// a multiply and an add on the callback thread.
+    ///
     /// @todo validate the direction of those offsets.
-    inline util::time::TimeValue
-    correctTimeByOffset(util::time::TimeValue const &tv,
-                        double eventTimeOffset) {
-        return tv + std::chrono::duration<double>(eventTimeOffset);
+    inline std::int64_t correctTimeByOffset(std::int64_t ns,
+                                            double eventTimeOffset) {
+        return ns + secondsToFastClockNs(eventTimeOffset);
+    }
+
+    static inline void copyMotion(const double linear[3],
+                                  const double angular[3],
+                                  TrackingReport::MotionPayload &motion) {
+        std::copy_n(linear, 3, motion.linear);
+        std::copy_n(angular, 3, motion.angular);
+    }
+
+    static inline void copyOffset(vr::HmdQuaternion_t const &q,
+                                  const double translation[3],
+                                  TrackingReport::OffsetPayload &offset) {
+        offset.rotation[0] = q.w;
+        offset.rotation[1] = q.x;
+        offset.rotation[2] = q.y;
+        offset.rotation[3] = q.z;
+        std::copy_n(translation, 3, offset.translation);
+    }
+
+    /// Lets the log know if a report queue had to drop anything or grow past
+    /// its capacity since the last call, and optionally if it reached a new
+    /// high-water mark.
+    template <typename Queue>
+    inline void logQueueStats(osvr::util::log::Logger &logger,
+                              const char *type, Queue const &queue,
+                              LoggedQueueStats &logged, bool logHighWater) {
+        auto dropped = queue.getDroppedCount();
+        auto overflows = queue.getOverflowCount();
+        if (dropped != logged.dropped) {
+            logger.warn() << "Report queue full (" << toString(queue.policy())
+                          << "): dropped " << (dropped - logged.dropped) << " "
+                          << type << " reports (" << dropped << " total)";
+        } else if (overflows != logged.overflows) {
+            logger.warn() << "Report queue past its capacity of "
+                          << queue.capacity() << ": kept "
+                          << (overflows - logged.overflows) << " more " << type
+                          << " reports anyway (" << overflows << " total)";
+        }
+        logged.dropped = dropped;
+        logged.overflows = overflows;
+        auto highWater = queue.getHighWaterMark();
+        if (logHighWater && highWater > logged.highWater) {
+            logger.info() << "Report queue high-water mark: " << highWater
+                          << " " << type << " reports waiting at once";
+            logged.highWater = highWater;
+        }
     }
 
-    ViveDriverHost::ViveDriverHost()
+    ViveDriverHost::ViveDriverHost(DriverHostConfig const &config)
         : m_universeXform(Eigen::Isometry3d::Identity()),
           m_universeRotation(Eigen::Quaterniond::Identity()),
-          m_logger(osvr::util::log::make_logger(PREFIX)),
-          m_puckIdx(PUCK_SENSOR), m_devDescriptor(com_osvr_Vive_json) {}
+          m_logger(osvr::util::log::make_logger(PREFIX)), m_config(config),
+          m_trackingThreadOffsets(vr::k_unMaxTrackedDeviceCount),
+          m_trackingThreadClocks(vr::k_unMaxTrackedDeviceCount),
+          m_trackingLanes(m_config.trackingQueue),
+          m_buttonReports(m_config.buttonQueue.capacity,
+                          m_config.buttonQueue.overflow),
+          m_analogReports(m_config.analogQueue.capacity,
+                          m_config.analogQueue.overflow),
+          m_trackingThreadAnalogs(NUM_ANALOGS), m_latestAnalogs(NUM_ANALOGS),
+          m_boundaryDistancesSent(BOUNDARY_DISTANCE_SENSORS,
+                                  std::numeric_limits<double>::quiet_NaN()),
+          m_puckIdx(PUCK_SENSOR), m_devDescriptor(com_osvr_Vive_json) {
+        if (m_config.coalescePoses) {
+            m_logger->info("Pose coalescing enabled: only the newest pose per "
+                           "sensor will be sent each update.");
+        }
+        /// Lock-free queues can't grow, so never-drop is drop-newest there.
+        auto checkPolicy = [&](const char *type, QueueConfig const &wanted,
+                               QueueOverflowPolicy actual) {
+            if (wanted.overflow != actual) {
+                m_logger->warn() << "The " << type << " report queue is "
+                                 << toString(actual) << ", not the configured "
+                                 << toString(wanted.overflow);
+            }
+        };
+        checkPolicy("tracking", m_config.trackingQueue,
+                    m_trackingLanes.others().reports.policy());
+        checkPolicy("button", m_config.buttonQueue, m_buttonReports.policy());
+        checkPolicy("analog", m_config.analogQueue, m_analogReports.policy());
+
+        for (auto &channel : m_trackingThreadAnalogs) {
+            channel.deadband = m_config.analogDeadband;
+        }
+        for (auto const &channel : m_config.analogChannelDeadbands) {
+            if (channel.first < m_trackingThreadAnalogs.size()) {
+                m_trackingThreadAnalogs[channel.first].deadband =
+                    channel.second;
+            }
+        }
+    }
+
+    ViveDriverHost::~ViveDriverHost() {
+        if (m_vive) {
+            m_vive->stopRunFrameThread();
+        }
+    }
 
     ViveDriverHost::StartResult
     ViveDriverHost::start(OSVR_PluginRegContext ctx,
@@ -153,7 +276,9 @@ namespace vive {
                     << serialNum << " couldn't be added to the devices vector.";
                 return false;
             }
-            NewDeviceReport out{std::string{serialNum}, ret.value};
+            auto isTracker = ret.value >= PUCK_SENSOR &&
+                             eDeviceClass == TrackedDeviceClass_GenericTracker;
+            NewDeviceReport out{std::string{serialNum}, ret.value, isTracker};
             {
                 std::lock_guard<std::mutex> lock(m_mutex);
                 m_newDevices.submitNew(std::move(out), lock);
@@ -228,77 +353,216 @@ namespace vive {
         /// Register update callback
         m_dev.registerUpdateCallback(this);
 
+        if (!m_config.sharedPoses.empty()) {
+            m_sharedPoses.reset(new SharedPosePublisher);
+            if (m_sharedPoses->open(m_config.sharedPoses)) {
+                m_logger->info("Publishing poses to shared memory segment ")
+                    << m_config.sharedPoses;
+            } else {
+                m_logger->warn("Could not publish poses to shared memory "
+                               "segment ")
+                    << m_config.sharedPoses << ": "
+                    << m_sharedPoses->errorMessage();
+                m_sharedPoses.reset();
+            }
+        }
+
+        m_chaperone = m_vive->shareChaperone();
+        if (m_config.reloadChaperone && m_vive->foundConfigDirs()) {
+            m_chaperoneWatcher.reset(new ChaperoneWatcher(
+                m_vive->getRootConfigDir(), m_chaperone));
+            m_logger->info("Watching ")
+                << ChaperoneData::getDataFilePath(m_vive->getRootConfigDir())
+                << (m_chaperoneWatcher->usingNotifications() ? ""
+                                                             : " (polling)")
+                << " for changes to reload";
+        }
+
+        if (m_config.runFrameRateHz > 0) {
+            m_logger->info("Calling RunFrame from a dedicated thread at ")
+                << m_config.runFrameRateHz << " Hz";
+            m_lastRunFrameStatsLog = osvr::util::time::getNow();
+            m_vive->startRunFrameThread(m_config.runFrameRateHz);
+        }
+
         return StartResult::Success;
     }
 
     inline OSVR_ReturnCode ViveDriverHost::update() {
 
-        m_vive->serverDevProvider().RunFrame();
+        /// Otherwise, the RunFrame thread has it covered and we just drain
+        /// what it produced.
+        if (!m_vive->haveRunFrameThread()) {
+            m_vive->serverDevProvider().RunFrame();
+        }
+
+        /// Late-latch the HMD lane: grabbed right after RunFrame and sent
+        /// ahead of everything else, so the freshest head pose goes out with
+        /// the least delay.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_trackingLanes.hmd().grabItems(lock);
+        } // unlock
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        m_grabNs = latencyClockNs();
+#endif
+        latchSendTime();
+        auto handle = [&](TrackingReport const &out) {
+            handleTrackingReport(out);
+        };
+        /// Up to any universe change: the other lane's poses from before it
+        /// go out first.
+        auto hmdAtUniverseChange =
+            m_trackingLanes.hmd().drainUntilUniverseChange(handle);
+        sendTrackerBatch();
 
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             /// Copy a fixed number of reports that have been queued up.
-            m_trackingReports.grabItems(lock);
+            m_trackingLanes.others().grabItems(lock);
+            if (!hmdAtUniverseChange) {
+                /// Along with the other lane, so a universe change the grab
+                /// catches is in both.
+                m_trackingLanes.hmd().grabItems(lock);
+            }
             m_buttonReports.grabItems(lock);
             m_analogReports.grabItems(lock);
+            m_newDevices.grabItems(lock);
 
         } // unlock
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        m_grabNs = latencyClockNs();
+#endif
+
+        /// Devices may be added from whatever thread calls RunFrame, so the
+        /// descriptor is only updated (and sent) from here.
+        bool descriptorChanged = false;
+        for (auto &dev : m_newDevices.accessWorkItems()) {
+            if (dev.isTracker) {
+                AddDeviceToDevDescriptor(dev.serialNumber.c_str(), dev.id);
+                descriptorChanged = true;
+            }
+        }
+        m_newDevices.clearWorkItems();
+        if (descriptorChanged) {
+            DeviceDescriptorUpdated();
+        }
+
         // Now that we're out of that mutex, we can go ahead and actually send
         // the reports.
-        for (auto &out : m_trackingReports.accessWorkItems()) {
-            if (out.isUniverseChange) {
-                handleUniverseChange(out.newUniverse);
-            } else {
-                convertAndSendTracker(out.timestamp, out.sensor, out.report);
-            }
+        latchSendTime();
+        // Poses are collected into a batch to convert all at once - flushed
+        // ahead of any universe change, since that changes the transforms.
+        m_trackingLanes.drainInOrder(hmdAtUniverseChange, handle);
+        sendTrackerBatch();
+        if (m_config.coalescePoses) {
+            logCoalescedPoses();
+        }
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        if (osvr::util::time::duration(m_sendTime, m_lastLatencyLog) >=
+            LATENCY_LOG_INTERVAL) {
+            logLatencyHistograms();
         }
-        // then clear this temporary buffer for next time. (done automatically,
-        // but doing it manually here since there will usually be lots of
-        // tracking reports.
-        m_trackingReports.clearWorkItems();
+#endif
 
         // Deal with the button reports.
         for (auto &out : m_buttonReports.accessWorkItems()) {
+            auto timestamp = m_clock.toTimeValue(out.timestampNs);
             osvrDeviceButtonSetValueTimestamped(
                 m_dev, m_button,
                 out.buttonState ? OSVR_BUTTON_PRESSED : OSVR_BUTTON_NOT_PRESSED,
-                out.sensor, &out.timestamp);
+                out.sensor, &timestamp);
         }
         m_buttonReports.clearWorkItems();
 
-        // Deal with analog reports
+        // Deal with analog reports: only the newest value per channel from
+        // this batch gets sent.
         for (auto &out : m_analogReports.accessWorkItems()) {
-            osvrDeviceAnalogSetValueTimestamped(m_dev, m_analog, out.value,
-                                                out.sensor, &out.timestamp);
+            setLatestAnalog(out.sensor, out.value, out.timestampNs);
             if (out.secondValid) {
-                osvrDeviceAnalogSetValueTimestamped(m_dev, m_analog, out.value2,
-                                                    out.sensor + 1,
-                                                    &out.timestamp);
+                setLatestAnalog(out.sensor + 1, out.value2, out.timestampNs);
             }
         }
         m_analogReports.clearWorkItems();
+        for (OSVR_ChannelCount sensor = 0; sensor < m_latestAnalogs.size();
+             ++sensor) {
+            auto &latest = m_latestAnalogs[sensor];
+            if (latest.valid) {
+                auto timestamp = m_clock.toTimeValue(latest.timestampNs);
+                osvrDeviceAnalogSetValueTimestamped(m_dev, m_analog,
+                                                    latest.value, sensor,
+                                                    &timestamp);
+                latest.valid = false;
+            }
+        }
+        logAnalogSuppression();
+        if (m_config.filterPoseTimestamps &&
+            osvr::util::time::duration(m_sendTime,
+                                       m_lastTransportLatencyLog) >=
+                TRANSPORT_LATENCY_LOG_INTERVAL) {
+            logTransportLatency();
+        }
+
+        /// Drops get logged as soon as they happen, new high-water marks
+        /// only every so often.
+        auto logHighWater =
+            osvr::util::time::duration(m_sendTime, m_lastHighWaterLog) >=
+            QUEUE_HIGH_WATER_LOG_INTERVAL;
+        logQueueStats(*m_logger, "HMD tracking",
+                      m_trackingLanes.hmd().reports,
+                      m_loggedHmdTrackingQueue, logHighWater);
+        logQueueStats(*m_logger, "tracking",
+                      m_trackingLanes.others().reports,
+                      m_loggedTrackingQueue, logHighWater);
+        logQueueStats(*m_logger, "button", m_buttonReports,
+                      m_loggedButtonQueue, logHighWater);
+        logQueueStats(*m_logger, "analog", m_analogReports,
+                      m_loggedAnalogQueue, logHighWater);
+        if (logHighWater) {
+            m_lastHighWaterLog = m_sendTime;
+        }
+
+        if (m_vive->haveRunFrameThread() &&
+            osvr::util::time::duration(m_sendTime, m_lastRunFrameStatsLog) >=
+                RUN_FRAME_STATS_LOG_INTERVAL) {
+            logRunFrameStats();
+        }
+
+        checkChaperoneReload();
 
         /// Try guessing the universe if we don't have an HMD to actually
-        /// provide it.
-        if (0 == m_universeId && !m_vive->devices().hasDeviceAt(HMD_SENSOR) &&
-            m_gotBaseStation) {
+        /// provide it. Only re-guessed when a new base station turns up (or
+        /// the chaperone data is reloaded).
+        auto baseStationGeneration =
+            m_baseStationGeneration.load(std::memory_order_acquire);
+        if (0 == m_universeId && !m_haveHmd && m_chaperone &&
+            baseStationGeneration != m_guessedBaseStationGeneration) {
             std::vector<std::string> baseStations;
             {
                 std::lock_guard<std::mutex> lock(m_baseStationMutex);
                 baseStations = m_baseStationSerials;
+                /// Re-read, in case one was added since.
+                baseStationGeneration =
+                    m_baseStationGeneration.load(std::memory_order_relaxed);
             }
-
-            auto id = m_vive->chaperone().guessUniverseIdFromBaseStations(
-                baseStations);
-            if (0 != id) {
+            m_guessedBaseStationGeneration = baseStationGeneration;
+            m_guessedUniverseId =
+                m_chaperone->guessUniverseIdFromBaseStations(baseStations);
+            if (0 != m_guessedUniverseId) {
                 m_logger->info("No HMD attached, but guessed universe from "
                                "sighted base stations...");
-                handleUniverseChange(id);
+                handleUniverseChange(m_guessedUniverseId);
             }
         }
         return OSVR_RETURN_SUCCESS;
     }
 
+    void ViveDriverHost::latchSendTime() {
+        m_clock.calibrate();
+        m_sendTime = m_clock.baseTime();
+        m_sendNs = m_clock.baseNs();
+    }
+
     ViveDriverHost::DevIdReturnValue
     ViveDriverHost::activateDevice(const char *serialNumber,
                                    vr::ITrackedDeviceServerDriver *dev,
@@ -316,6 +580,13 @@ namespace vive {
         }
         os += mfrProp.first + " " + modelProp.first + " " + serialProp.first;
         m_logger->info(os.c_str());
+        if (trackedDeviceClass ==
+                vr::ETrackedDeviceClass::TrackedDeviceClass_TrackingReference &&
+            serialNumber && serialNumber[0] != '\0') {
+            /// Sighted base stations are what the universe is guessed from
+            /// when there's no HMD - whether or not this one got a sensor.
+            recordBaseStationSerial(serialNumber);
+        }
         return ret;
     }
 
@@ -326,7 +597,11 @@ namespace vive {
         if (getComponent<vr::IVRDisplayComponent>(dev)) {
             /// This is the HMD, since it has the display component.
             /// Always sensor 0.
-            return devs.addAndActivateDeviceAt(dev, HMD_SENSOR);
+            auto ret = devs.addAndActivateDeviceAt(dev, HMD_SENSOR);
+            if (ret) {
+                m_haveHmd = true;
+            }
+            return ret;
         }
 
         if (getComponent<vr::IVRControllerComponent>(dev)) {
@@ -339,10 +614,9 @@ namespace vive {
                 while (devs.hasDeviceAt(m_puckIdx)) {
                     m_puckIdx++;
                 }
+                /// The device descriptor is updated from update(), once this
+                /// comes through m_newDevices.
                 auto ret = devs.addAndActivateDeviceAt(dev, m_puckIdx);
-                // need to update device descriptor
-                AddDeviceToDevDescriptor(serialNumber, m_puckIdx);
-                DeviceDescriptorUpdated();
                 m_puckIdx++;
                 return ret;
             }
@@ -374,73 +648,388 @@ namespace vive {
         return std::cout;
     }
 
+    SensorClassConfig const &
+    ViveDriverHost::getSensorClassConfig(OSVR_ChannelCount sensor) const {
+        if (sensor == HMD_SENSOR) {
+            return m_config.hmd;
+        }
+        if (sensor <= MAX_CONTROLLER_ID) {
+            return m_config.controllers;
+        }
+        if (sensor < PUCK_SENSOR) {
+            return m_config.baseStations;
+        }
+        return m_config.trackers;
+    }
+
     void ViveDriverHost::recordBaseStationSerial(const char *serial) {
-        {
-            std::lock_guard<std::mutex> lock(m_baseStationMutex);
-            m_baseStationSerials.emplace_back(serial);
+        std::string serialString(serial);
+        std::lock_guard<std::mutex> lock(m_baseStationMutex);
+        auto it = std::lower_bound(m_baseStationSerials.begin(),
+                                   m_baseStationSerials.end(), serialString);
+        if (it != m_baseStationSerials.end() && *it == serialString) {
+            /// Already seen - nothing to re-guess.
+            return;
         }
-        m_gotBaseStation = true;
+        m_baseStationSerials.insert(it, std::move(serialString));
+        m_baseStationGeneration.fetch_add(1, std::memory_order_release);
     }
 
     void ViveDriverHost::submitTrackingReport(uint32_t unWhichDevice,
-                                              OSVR_TimeValue const &tv,
+                                              std::int64_t nowNs,
                                               const DriverPose_t &newPose) {
-        TrackingReport out;
-        out.timestamp = tv;
-        out.sensor = unWhichDevice;
-        out.report = newPose;
-        {
+        auto sensor = static_cast<OSVR_ChannelCount>(unWhichDevice);
+
+        if (!(unWhichDevice < m_trackingThreadOffsets.size())) {
+            /// Out of range for everything sized per device.
+            return;
+        }
+
+        /// The offsets almost never change, so they only get queued when they
+        /// do (or when the last ones we queued might have been dropped).
+        auto &queued = m_trackingThreadOffsets[unWhichDevice];
+        auto offsets = getPoseOffsets(newPose);
+        auto drops = m_trackingReportDrops.load(std::memory_order_acquire);
+        if (!queued.valid || queued.drops != drops ||
+            !(queued.offsets == offsets)) {
+            std::array<TrackingReport, 2> changes;
+            changes[0].kind = TrackingReport::Kind::WorldFromDriver;
+            changes[0].sensor = sensor;
+            copyOffset(newPose.qWorldFromDriverRotation,
+                       newPose.vecWorldFromDriverTranslation,
+                       changes[0].offset);
+            changes[1].kind = TrackingReport::Kind::DriverFromHead;
+            changes[1].sensor = sensor;
+            copyOffset(newPose.qDriverFromHeadRotation,
+                       newPose.vecDriverFromHeadTranslation,
+                       changes[1].offset);
+            queued.valid =
+                submitOrderedTrackingReports(changes.data(), changes.size());
+            queued.drops = drops;
+            queued.offsets = offsets;
+        }
+
+        /// The pose, plus the optional records that follow it, indexed by
+        /// slot.
+        std::array<TrackingReport, TRACKING_SLOTS_PER_SENSOR> reports;
+        std::array<bool, TRACKING_SLOTS_PER_SENSOR> wanted = {
+            {true, false, false}};
+        auto &out = reports[POSE_SLOT];
+        out.kind = TrackingReport::Kind::Pose;
+        out.poseIsValid = newPose.poseIsValid;
+        out.result = static_cast<std::int16_t>(newPose.result);
+        out.sensor = sensor;
+        out.pose.timestampNs =
+            correctTimeByOffset(nowNs, newPose.poseTimeOffset);
+        out.pose.latencyUs = 0;
+        if (m_config.filterPoseTimestamps) {
+            auto &clock = m_trackingThreadClocks[unWhichDevice];
+            out.pose.timestampNs = clock.update(nowNs, out.pose.timestampNs);
+            if (clock.locked()) {
+                out.pose.latencyUs =
+                    static_cast<std::int32_t>(clock.latencyNs() / 1000);
+            }
+        }
+        std::copy_n(newPose.vecPosition, 3, out.pose.position);
+
+        LatestPose latest;
+        latest.timestampNs = out.pose.timestampNs;
+        latest.offsets = offsets;
+        std::copy_n(newPose.vecPosition, 3, latest.position);
+        latest.rotation = newPose.qRotation;
+        std::copy_n(newPose.vecVelocity, 3, latest.velocity);
+        std::copy_n(newPose.vecAngularVelocity, 3, latest.angularVelocity);
+        latest.result = static_cast<std::int32_t>(newPose.result);
+        latest.poseIsValid = newPose.poseIsValid;
+        latest.deviceIsConnected = newPose.deviceIsConnected;
+        m_latestPoses.write(unWhichDevice, latest);
+
+        out.pose.rotation[0] = static_cast<float>(newPose.qRotation.w);
+        out.pose.rotation[1] = static_cast<float>(newPose.qRotation.x);
+        out.pose.rotation[2] = static_cast<float>(newPose.qRotation.y);
+        out.pose.rotation[3] = static_cast<float>(newPose.qRotation.z);
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        out.queuedNs = latencyClockNs();
+#endif
+
+        auto const &classConfig = getSensorClassConfig(sensor);
+        if (classConfig.reportVelocity || classConfig.predictionMs > 0) {
+            auto &vel = reports[VELOCITY_SLOT];
+            vel.kind = TrackingReport::Kind::Velocity;
+            vel.sensor = sensor;
+            copyMotion(newPose.vecVelocity, newPose.vecAngularVelocity,
+                       vel.motion);
+            wanted[VELOCITY_SLOT] = true;
+        }
+        if (classConfig.reportAcceleration) {
+            auto &accel = reports[ACCELERATION_SLOT];
+            accel.kind = TrackingReport::Kind::Acceleration;
+            accel.sensor = sensor;
+            copyMotion(newPose.vecAcceleration, newPose.vecAngularAcceleration,
+                       accel.motion);
+            wanted[ACCELERATION_SLOT] = true;
+        }
+
+        auto &lane = m_trackingLanes.laneFor(sensor);
+        if (m_config.coalescePoses) {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_trackingReports.submitNew(std::move(out), lock);
+            for (std::size_t slot = 0; slot < reports.size(); ++slot) {
+                if (wanted[slot]) {
+                    lane.latest.submitNew(
+                        sensor * TRACKING_SLOTS_PER_SENSOR + slot,
+                        reports[slot], lock);
+                }
+            }
+            return;
+        }
+        for (std::size_t slot = 0; slot < reports.size(); ++slot) {
+            if (wanted[slot] &&
+                !submitToQueue(lane.reports, m_mutex, reports[slot])) {
+                trackingReportDropped();
+            }
         }
     }
 
+    void ViveDriverHost::trackingReportDropped() {
+        m_trackingReportDrops.fetch_add(1, std::memory_order_acq_rel);
+    }
+
     void ViveDriverHost::submitUniverseChange(std::uint64_t newUniverse) {
         TrackingReport out;
-        out.isUniverseChange = true;
+        out.kind = TrackingReport::Kind::UniverseChange;
         out.newUniverse = newUniverse;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_trackingReports.submitNew(std::move(out), lock);
+        if (!m_trackingLanes.submitUniverseChange(m_mutex, out,
+                                                  m_config.coalescePoses)) {
+            trackingReportDropped();
+        }
+    }
+
+    bool
+    ViveDriverHost::submitOrderedTrackingReports(TrackingReport const *reports,
+                                                 std::size_t n) {
+        if (0 == n) {
+            return true;
+        }
+        /// All reports passed in together are about one sensor.
+        auto &lane = m_trackingLanes.laneFor(reports[0].sensor);
+        auto ret =
+            lane.submitOrdered(m_mutex, reports, n, m_config.coalescePoses);
+        if (!ret) {
+            trackingReportDropped();
+        }
+        return ret;
+    }
+
+    void ViveDriverHost::logCoalescedPoses() {
+        auto now = osvr::util::time::getNow();
+        if (osvr::util::time::duration(now, m_lastCoalescedPoseLog) <
+            COALESCED_POSE_LOG_INTERVAL) {
+            return;
+        }
+        auto numSensors =
+            (m_trackingLanes.others().latest.getDroppedCounts().size() +
+                           TRACKING_SLOTS_PER_SENSOR - 1) /
+                          TRACKING_SLOTS_PER_SENSOR;
+        numSensors = std::max<std::size_t>(
+            numSensors, TrackingLanesType::HMD_LANE_SENSOR + 1);
+        m_loggedCoalescedPoses.resize(numSensors, 0);
+        std::ostringstream os;
+        std::uint64_t total = 0;
+        /// Velocities and accelerations are replaced along with their poses,
+        /// so just count the poses.
+        for (std::size_t sensor = 0; sensor < numSensors; ++sensor) {
+            auto const &dropped =
+                m_trackingLanes.laneFor(sensor).latest.getDroppedCounts();
+            auto idx = sensor * TRACKING_SLOTS_PER_SENSOR + POSE_SLOT;
+            auto poseDropped = idx < dropped.size() ? dropped[idx] : 0;
+            auto newlyDropped = poseDropped - m_loggedCoalescedPoses[sensor];
+            if (newlyDropped > 0) {
+                os << " [sensor " << sensor << ": " << newlyDropped << "]";
+                total += newlyDropped;
+                m_loggedCoalescedPoses[sensor] = poseDropped;
+            }
+        }
+        if (total > 0) {
+            m_logger->info() << "Dropped " << total
+                             << " stale poses in favor of newer ones:"
+                             << os.str();
+        }
+        m_lastCoalescedPoseLog = now;
+    }
+
+    void ViveDriverHost::setLatestAnalog(OSVR_ChannelCount sensor,
+                                         double value,
+                                         std::int64_t timestampNs) {
+        if (!(sensor < m_latestAnalogs.size())) {
+            m_latestAnalogs.resize(sensor + 1);
+        }
+        auto &latest = m_latestAnalogs[sensor];
+        if (latest.valid) {
+            ++m_analogCoalesced;
+        }
+        latest.valid = true;
+        latest.value = value;
+        latest.timestampNs = timestampNs;
+    }
+
+    void ViveDriverHost::logAnalogSuppression() {
+        auto now = osvr::util::time::getNow();
+        if (osvr::util::time::duration(now, m_lastAnalogSuppressionLog) <
+            ANALOG_SUPPRESSION_LOG_INTERVAL) {
+            return;
+        }
+        auto deadband =
+            m_analogDeadbandSuppressed.load(std::memory_order_relaxed);
+        auto newDeadband = deadband - m_loggedAnalogDeadbandSuppressed;
+        auto newCoalesced = m_analogCoalesced - m_loggedAnalogCoalesced;
+        if (newDeadband > 0 || newCoalesced > 0) {
+            m_logger->info() << "Analog reports not sent: " << newDeadband
+                             << " inside the deadband, " << newCoalesced
+                             << " replaced by newer values ("
+                             << (deadband + m_analogCoalesced) << " total)";
+            m_loggedAnalogDeadbandSuppressed = deadband;
+            m_loggedAnalogCoalesced = m_analogCoalesced;
+        }
+        m_lastAnalogSuppressionLog = now;
+    }
+
+    void ViveDriverHost::logTransportLatency() {
+        std::ostringstream os;
+        for (OSVR_ChannelCount sensor = 0; sensor < m_transportLatencyUs.size();
+             ++sensor) {
+            if (m_transportLatencyUs[sensor] != 0) {
+                os << " " << sensor << ": " << m_transportLatencyUs[sensor];
+            }
+        }
+        auto str = os.str();
+        if (!str.empty()) {
+            m_logger->info() << "Estimated pose transport latency by sensor "
+                                "(microseconds):"
+                             << str;
         }
+        m_lastTransportLatencyLog = m_sendTime;
     }
 
+    void ViveDriverHost::logRunFrameStats() {
+        auto stats = m_vive->takeRunFrameStats();
+        /// Milliseconds, to keep the numbers readable.
+        auto ms = [](double seconds) { return seconds * 1000.; };
+        m_logger->info() << "RunFrame thread: " << stats.frames
+                         << " frames, interval (ms) mean "
+                         << ms(stats.meanInterval) << ", std dev "
+                         << ms(stats.stdDevInterval) << ", min "
+                         << ms(stats.minInterval) << ", max "
+                         << ms(stats.maxInterval) << "; " << stats.overruns
+                         << " overran the period";
+        m_lastRunFrameStatsLog = osvr::util::time::getNow();
+    }
+
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+    ViveDriverHost::SensorLatency &
+    ViveDriverHost::getSensorLatency(OSVR_ChannelCount sensor) {
+        if (!(sensor < m_latency.size())) {
+            m_latency.resize(sensor + 1);
+        }
+        return m_latency[sensor];
+    }
+
+    void ViveDriverHost::logLatencyHistograms() {
+        /// Microseconds, to keep the numbers readable.
+        auto us = [](std::int64_t ns) { return ns / 1000; };
+        auto describe = [&](std::ostream &os, LatencyHistogram const &h) {
+            os << "p50 " << us(h.percentile(0.5)) << ", p90 "
+               << us(h.percentile(0.9)) << ", p99 " << us(h.percentile(0.99))
+               << ", max " << us(h.max());
+        };
+        for (std::size_t sensor = 0; sensor < m_latency.size(); ++sensor) {
+            auto &latency = m_latency[sensor];
+            if (0 == latency.grabbed.count()) {
+                continue;
+            }
+            std::ostringstream os;
+            os << "Pose latency (us) for sensor " << sensor << " over "
+               << latency.grabbed.count() << " poses - until grabbed: ";
+            describe(os, latency.grabbed);
+            os << "; until sent: ";
+            describe(os, latency.sent);
+            m_logger->info() << os.str();
+            latency.grabbed.reset();
+            latency.sent.reset();
+        }
+        m_lastLatencyLog = osvr::util::time::getNow();
+    }
+#endif
+
     void ViveDriverHost::submitButton(OSVR_ChannelCount sensor, bool state,
                                       double eventTimeOffset) {
         ButtonReport out;
-        out.timestamp =
-            correctTimeByOffset(osvr::util::time::getNow(), eventTimeOffset);
+        out.timestampNs = correctTimeByOffset(fastClockNs(), eventTimeOffset);
         out.sensor = sensor;
         out.buttonState = state ? OSVR_BUTTON_PRESSED : OSVR_BUTTON_NOT_PRESSED;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_buttonReports.submitNew(std::move(out), lock);
+        submitToQueue(m_buttonReports, m_mutex, std::move(out));
+    }
+
+    bool ViveDriverHost::analogChanged(OSVR_ChannelCount sensor,
+                                       double value) const {
+        if (!(sensor < m_trackingThreadAnalogs.size())) {
+            return true;
+        }
+        auto const &channel = m_trackingThreadAnalogs[sensor];
+        if (!channel.sent || channel.deadband <= 0) {
+            return true;
+        }
+        if (value == channel.value) {
+            return false;
+        }
+        /// Always let a control come to rest exactly at the center or either
+        /// end of its range, even by a step inside the deadband.
+        if (value == 0. || value == 1. || value == -1.) {
+            return true;
+        }
+        return std::abs(value - channel.value) > channel.deadband;
+    }
+
+    void ViveDriverHost::recordAnalogSent(OSVR_ChannelCount sensor,
+                                          double value) {
+        if (sensor < m_trackingThreadAnalogs.size()) {
+            auto &channel = m_trackingThreadAnalogs[sensor];
+            channel.sent = true;
+            channel.value = value;
         }
     }
 
     void ViveDriverHost::submitAnalog(OSVR_ChannelCount sensor, double value) {
+        /// Checked before anything else, so a suppressed report costs neither
+        /// a timestamp nor a lock.
+        if (!analogChanged(sensor, value)) {
+            m_analogDeadbandSuppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        recordAnalogSent(sensor, value);
         AnalogReport out;
-        out.timestamp = osvr::util::time::getNow();
+        out.timestampNs = fastClockNs();
         out.sensor = sensor;
         out.value = value;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_analogReports.submitNew(std::move(out), lock);
-        }
+        submitToQueue(m_analogReports, m_mutex, std::move(out));
     }
 
     void ViveDriverHost::submitAnalogs(OSVR_ChannelCount sensor, double value1,
                                        double value2) {
+        /// Both axes go together, so send both if either moved enough.
+        if (!analogChanged(sensor, value1) &&
+            !analogChanged(sensor + 1, value2)) {
+            m_analogDeadbandSuppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        recordAnalogSent(sensor, value1);
+        recordAnalogSent(sensor + 1, value2);
         AnalogReport out;
-        out.timestamp = osvr::util::time::getNow();
+        out.timestampNs = fastClockNs();
         out.sensor = sensor;
         out.value = value1;
         out.secondValid = true;
         out.value2 = value2;
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_analogReports.submitNew(std::move(out), lock);
-        }
+        submitToQueue(m_analogReports, m_mutex, std::move(out));
     }
     static inline const char *
     trackingResultToString(vr::ETrackingResult trackingResult) {
@@ -466,77 +1055,422 @@ namespace vive {
             break;
         }
     }
-    void ViveDriverHost::convertAndSendTracker(OSVR_TimeValue const &tv,
-                                               OSVR_ChannelCount sensor,
-                                               const DriverPose_t &newPose) {
+    /// Places a latest pose table entry in the driver's world space, dt
+    /// seconds after it was sampled.
+    static inline void toTrackedDevicePose(LatestPose const &latest, double dt,
+                                           vr::TrackedDevicePose_t &out) {
+        using namespace Eigen;
+        Vector3d position = Vector3d::Map(latest.position);
+        Quaterniond rotation = quatFromSteamVR(latest.rotation);
+        Vector3d velocity = Vector3d::Map(latest.velocity);
+        Vector3d angularVelocity = Vector3d::Map(latest.angularVelocity);
+        if (latest.poseIsValid && dt > 0) {
+            predictPose(position, rotation, velocity, angularVelocity, dt);
+        }
+        /// The same conversion as the OSVR reports, minus the universe:
+        /// SteamVR's raw poses are in its own world space.
+        SensorTransformCache xforms;
+        xforms.offsets = latest.offsets;
+        computeSensorTransforms(Isometry3d::Identity(),
+                                Quaterniond::Identity(), xforms);
+        Vector3d worldPosition;
+        Quaterniond worldRotation;
+        convertPose(xforms, position, rotation, worldPosition, worldRotation);
+        Isometry3d worldFromHead =
+            Translation3d(worldPosition) * worldRotation;
+        Matrix<float, 3, 4> m =
+            worldFromHead.matrix().topRows<3>().cast<float>();
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) {
+                out.mDeviceToAbsoluteTracking.m[row][col] = m(row, col);
+            }
+        }
+        Vector3f::Map(out.vVelocity.v) =
+            (xforms.universeFromDriverRotation *
+             headLinearVelocity(velocity, angularVelocity, rotation,
+                                xforms.driverFromHeadTranslation))
+                .cast<float>();
+        Vector3f::Map(out.vAngularVelocity.v) =
+            (xforms.universeFromDriverRotation * angularVelocity)
+                .cast<float>();
+        out.eTrackingResult = static_cast<vr::ETrackingResult>(latest.result);
+        out.bPoseIsValid = latest.poseIsValid;
+        out.bDeviceIsConnected = latest.deviceIsConnected;
+    }
+
+    void ViveDriverHost::GetRawTrackedDevicePoses(
+        float fPredictedSecondsFromNow,
+        TrackedDevicePose_t *pTrackedDevicePoseArray,
+        uint32_t unTrackedDevicePoseArrayCount) {
+        auto nowNs = fastClockNs();
+        for (uint32_t i = 0; i < unTrackedDevicePoseArrayCount; ++i) {
+            auto &out = pTrackedDevicePoseArray[i];
+            LatestPose latest;
+            if (!m_latestPoses.read(i, latest)) {
+                out = TrackedDevicePose_t{};
+                out.eTrackingResult = vr::TrackingResult_Uninitialized;
+                continue;
+            }
+            /// Predict from when it was sampled, but no further than we
+            /// would for the OSVR reports.
+            auto dt = (nowNs - latest.timestampNs) * 1e-9 +
+                      fPredictedSecondsFromNow;
+            toTrackedDevicePose(latest, std::min(dt, MAX_PREDICTION_INTERVAL),
+                                out);
+        }
+    }
+
+    SensorTransformCache const *
+    ViveDriverHost::getTransformCache(OSVR_ChannelCount sensor) {
+        if (!(sensor < m_transformCache.size())) {
+            return nullptr;
+        }
+        auto &cache = m_transformCache[sensor];
+        if (cache.valid) {
+            return &cache;
+        }
+        if (!cache.haveWorldFromDriver || !cache.haveDriverFromHead) {
+            return nullptr;
+        }
+
+        computeSensorTransforms(m_universeXform, m_universeRotation, cache);
+        return &cache;
+    }
+
+    void ViveDriverHost::handleOffsetsReport(TrackingReport const &report) {
+        auto sensor = report.sensor;
+        if (!(sensor < m_transformCache.size())) {
+            m_transformCache.resize(sensor + 1);
+        }
+        auto &cache = m_transformCache[sensor];
+        auto const &offset = report.offset;
+        vr::HmdQuaternion_t q;
+        q.w = offset.rotation[0];
+        q.x = offset.rotation[1];
+        q.y = offset.rotation[2];
+        q.z = offset.rotation[3];
+        if (report.kind == TrackingReport::Kind::WorldFromDriver) {
+            cache.offsets.qWorldFromDriverRotation = q;
+            std::copy_n(offset.translation, 3,
+                        cache.offsets.vecWorldFromDriverTranslation);
+            cache.haveWorldFromDriver = true;
+        } else {
+            cache.offsets.qDriverFromHeadRotation = q;
+            std::copy_n(offset.translation, 3,
+                        cache.offsets.vecDriverFromHeadTranslation);
+            cache.haveDriverFromHead = true;
+        }
+        cache.valid = false;
+    }
+
+    void ViveDriverHost::handleTrackingReport(TrackingReport const &report) {
+        switch (report.kind) {
+        case TrackingReport::Kind::Pose:
+            batchTracker(report);
+            break;
+        case TrackingReport::Kind::WorldFromDriver:
+        case TrackingReport::Kind::DriverFromHead:
+            /// Batched poses already have their transforms copied.
+            handleOffsetsReport(report);
+            break;
+        case TrackingReport::Kind::Velocity:
+            handleVelocityReport(report);
+            break;
+        case TrackingReport::Kind::Acceleration:
+            handleMotionReport(report);
+            break;
+        case TrackingReport::Kind::UniverseChange:
+            sendTrackerBatch();
+            /// Each lane carries a copy, handed over one right after the
+            /// other: only the first counts.
+            if (!m_handledUniverseChange ||
+                report.newUniverse != m_lastUniverseChange) {
+                m_handledUniverseChange = true;
+                m_lastUniverseChange = report.newUniverse;
+                handleUniverseChange(report.newUniverse);
+            }
+            break;
+        }
+    }
+
+    void ViveDriverHost::batchTracker(TrackingReport const &report) {
+        auto sensor = report.sensor;
+        auto result = static_cast<vr::ETrackingResult>(report.result);
         if (!(sensor < m_trackingResults.size())) {
             m_trackingResults.resize(sensor + 1,
                                      vr::TrackingResult_Uninitialized);
         }
 
-        if (newPose.result != m_trackingResults[sensor]) {
+        if (result != m_trackingResults[sensor]) {
             msg() << "Sensor " << sensor << " changed status from '"
                   << trackingResultToString(m_trackingResults[sensor])
-                  << "' to '" << trackingResultToString(newPose.result) << "'"
+                  << "' to '" << trackingResultToString(result) << "'"
                   << std::endl;
-            m_trackingResults[sensor] = newPose.result;
+            m_trackingResults[sensor] = result;
         }
-        if (!newPose.poseIsValid) {
+
+        if (!(sensor < m_lastPoses.size())) {
+            m_lastPoses.resize(sensor + 1);
+        }
+        auto &lastPose = m_lastPoses[sensor];
+        auto previousTimestampNs = lastPose.timestampNs;
+        lastPose.batched = false;
+        lastPose.inBatch = false;
+        lastPose.haveVelocity = false;
+        lastPose.invalidToPublish = false;
+        if (!report.poseIsValid) {
             /// @todo better handle non-valid states?
+            /// Published with the batch, as this sensor's newest.
+            lastPose.invalidToPublish = true;
+            lastPose.invalidTimestamp =
+                m_clock.toTimeValue(report.pose.timestampNs);
             return;
         }
-        auto quatFromSteamVR = [](vr::HmdQuaternion_t const &q) {
-            return Eigen::Quaterniond(q.w, q.x, q.y, q.z);
-        };
 
-        using namespace Eigen;
+        auto xforms = getTransformCache(sensor);
+        if (!xforms) {
+            /// Offsets were dropped on the way here - they'll be re-sent with
+            /// a later pose.
+            return;
+        }
+        lastPose.batchIndex = m_poseBatch.size();
+        auto timestamp = m_clock.toTimeValue(report.pose.timestampNs);
+        m_poseBatch.add(sensor, timestamp, report.pose.position,
+                        report.pose.rotation, *xforms);
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        m_batchQueuedNs.push_back(report.queuedNs);
+        getSensorLatency(sensor).grabbed.record(m_grabNs - report.queuedNs);
+#endif
+        lastPose.batched = true;
+        lastPose.inBatch = true;
+        lastPose.timestamp = timestamp;
+        lastPose.timestampNs = report.pose.timestampNs;
+        std::copy_n(report.pose.rotation, 4, lastPose.rotation);
+        auto intervalNs = report.pose.timestampNs - previousTimestampNs;
+        lastPose.incrementDt =
+            previousTimestampNs != 0 && intervalNs > 0
+                ? std::min(intervalNs * 1e-9, ANGULAR_INCREMENT_DT)
+                : ANGULAR_INCREMENT_DT;
+        if (report.pose.latencyUs != 0) {
+            if (!(sensor < m_transportLatencyUs.size())) {
+                m_transportLatencyUs.resize(sensor + 1, 0);
+            }
+            m_transportLatencyUs[sensor] = report.pose.latencyUs;
+        }
+    }
 
-        auto qRotation = quatFromSteamVR(newPose.qRotation);
+    void ViveDriverHost::handleVelocityReport(TrackingReport const &report) {
+        /// The driver's velocity is its tracked point's: what we report goes
+        /// with the pose we send, so it's the head's. (Prediction works that
+        /// out in the batch.)
+        TrackingReport headReport = report;
+        auto xforms = getTransformCache(report.sensor);
+        if (report.sensor < m_lastPoses.size() &&
+            m_lastPoses[report.sensor].batched && xforms) {
+            using namespace Eigen;
+            auto const &rotation = m_lastPoses[report.sensor].rotation;
+            Vector3d::Map(headReport.motion.linear) = headLinearVelocity(
+                Vector3d::Map(report.motion.linear),
+                Vector3d::Map(report.motion.angular),
+                Quaterniond(rotation[0], rotation[1], rotation[2],
+                            rotation[3]),
+                xforms->driverFromHeadTranslation);
+        }
+        if (m_sharedPoses && report.sensor < m_lastPoses.size()) {
+            auto &lastPose = m_lastPoses[report.sensor];
+            if (lastPose.inBatch && xforms) {
+                using namespace Eigen;
+                Vector3d::Map(lastPose.linearVelocity) =
+                    xforms->universeFromDriverRotation *
+                    Vector3d::Map(headReport.motion.linear);
+                Vector3d::Map(lastPose.angularVelocity) =
+                    xforms->universeFromDriverRotation *
+                    Vector3d::Map(report.motion.angular);
+                lastPose.haveVelocity = true;
+            }
+        }
+        auto const &classConfig = getSensorClassConfig(report.sensor);
+        if (classConfig.reportVelocity) {
+            handleMotionReport(headReport);
+        }
+        if (!(classConfig.predictionMs > 0) ||
+            !(report.sensor < m_lastPoses.size())) {
+            return;
+        }
+        auto const &lastPose = m_lastPoses[report.sensor];
+        if (!lastPose.inBatch) {
+            /// The pose wasn't valid, or went out ahead of a universe change.
+            return;
+        }
+        /// Predict to a fixed interval past now, but never further than
+        /// MAX_PREDICTION_INTERVAL past the sample (nor before it).
+        auto dt = (m_sendNs - lastPose.timestampNs) * 1e-9 +
+                  classConfig.predictionMs / 1000.;
+        dt = std::min(std::max(dt, 0.), MAX_PREDICTION_INTERVAL);
+        m_poseBatch.predict(
+            lastPose.batchIndex, report.motion.linear, report.motion.angular,
+            m_clock.toTimeValue(lastPose.timestampNs +
+                                secondsToFastClockNs(dt)));
+    }
 
-        auto driverFromHeadRotation =
-            quatFromSteamVR(newPose.qDriverFromHeadRotation);
+    /// Expresses an angular rate (axis-angle, radians per second) the way
+    /// OSVR wants it: as the rotation over a short time step, dt.
+    static inline OSVR_IncrementalQuaternion
+    incrementalRotationFromRate(Eigen::Vector3d const &rate, double dt) {
+        OSVR_IncrementalQuaternion ret;
+        ret.dt = dt;
+        auto angle = rate.norm() * ret.dt;
+        Eigen::Quaterniond q = Eigen::Quaterniond::Identity();
+        if (angle > 0) {
+            q = Eigen::AngleAxisd(angle, rate.normalized());
+        }
+        ei::map(ret.incrementalRotation) = q;
+        return ret;
+    }
 
-        Translation3d driverFromHeadTranslation(
-            Vector3d::Map(newPose.vecDriverFromHeadTranslation));
-        Isometry3d driverFromHead =
-            driverFromHeadTranslation * driverFromHeadRotation;
-#if 0
-        driverFromHead.fromPositionOrientationScale(
-            Vector3d::Map(newPose.vecDriverFromHeadTranslation),
-            driverFromHeadRotation, Vector3d::Ones());
-#endif
-        auto worldFromDriverRotation =
-            quatFromSteamVR(newPose.qWorldFromDriverRotation);
-        Translation3d worldFromDriverTranslation(
-            Vector3d::Map(newPose.vecWorldFromDriverTranslation));
-        Isometry3d worldFromDriver =
-            worldFromDriverTranslation * worldFromDriverRotation;
-#if 0
-        worldFromDriver.fromPositionOrientationScale(
-            Eigen::Vector3d::Map(newPose.vecWorldFromDriverTranslation),
-            worldFromDriverRotation, Eigen::Vector3d::Ones());
-#endif
-#if 0
-        ei::map(pose.translation) =
-            (worldFromDriverTranslation * worldFromDriverRotation *
-                Eigen::Translation3d(Eigen::Vector3d::Map(newPose.vecPosition)) *
-                driverFromHeadTranslation * worldFromDriverRotation)
-            .translation();
+    void ViveDriverHost::handleMotionReport(TrackingReport const &report) {
+        auto sensor = report.sensor;
+        if (!(sensor < m_lastPoses.size()) || !m_lastPoses[sensor].batched) {
+            /// Goes with a pose we didn't send.
+            return;
+        }
+        auto const &lastPose = m_lastPoses[sensor];
+        if (lastPose.inBatch) {
+            /// Held until the pose it goes with is sent.
+            PendingMotion pending;
+            pending.report = report;
+            pending.batchIndex = lastPose.batchIndex;
+            pending.incrementDt = lastPose.incrementDt;
+            m_pendingMotion.push_back(pending);
+            return;
+        }
+        /// The pose already went out, ahead of a universe change.
+        sendMotion(report, lastPose.timestamp, lastPose.incrementDt);
+    }
+
+    void ViveDriverHost::sendMotion(TrackingReport const &report,
+                                    OSVR_TimeValue const &timestamp,
+                                    double incrementDt) {
+        auto sensor = report.sensor;
+        auto xforms = getTransformCache(sensor);
+        if (!xforms) {
+            return;
+        }
+        /// Both are free vectors, so only rotation applies.
+        using namespace Eigen;
+        Vector3d linear = xforms->universeFromDriverRotation *
+                          Vector3d::Map(report.motion.linear);
+        Vector3d angular = xforms->universeFromDriverRotation *
+                           Vector3d::Map(report.motion.angular);
+        if (report.kind == TrackingReport::Kind::Velocity) {
+            OSVR_VelocityState state;
+            ei::map(state.linearVelocity) = linear;
+            state.linearVelocityValid = OSVR_TRUE;
+            state.angularVelocity =
+                incrementalRotationFromRate(angular, incrementDt);
+            state.angularVelocityValid = OSVR_TRUE;
+            osvrDeviceTrackerSendVelocityTimestamped(m_dev, m_tracker, &state,
+                                                     sensor, &timestamp);
+        } else {
+            OSVR_AccelerationState state;
+            ei::map(state.linearAcceleration) = linear;
+            state.linearAccelerationValid = OSVR_TRUE;
+            state.angularAcceleration =
+                incrementalRotationFromRate(angular, incrementDt);
+            state.angularAccelerationValid = OSVR_TRUE;
+            osvrDeviceTrackerSendAccelerationTimestamped(
+                m_dev, m_tracker, &state, sensor, &timestamp);
+        }
+    }
+
+    void ViveDriverHost::sendTrackerBatch() {
+        if (m_poseBatch.empty()) {
+            /// There may still be poses that turned out invalid.
+            if (m_sharedPoses) {
+                publishSharedPoses();
+            }
+            return;
+        }
+        m_poseBatch.convert();
+        for (std::size_t i = 0, e = m_poseBatch.size(); i < e; ++i) {
+            osvrDeviceTrackerSendPoseTimestamped(
+                m_dev, m_tracker, &m_poseBatch.getPose(i),
+                m_poseBatch.getSensor(i), &m_poseBatch.getTimestamp(i));
+        }
+        /// With the timestamps of their poses, as sent (so, predicted).
+        for (auto const &pending : m_pendingMotion) {
+            sendMotion(pending.report,
+                       m_poseBatch.getTimestamp(pending.batchIndex),
+                       pending.incrementDt);
+        }
+        m_pendingMotion.clear();
+        if (m_config.reportBoundaryDistance && m_playAreaBounds) {
+            sendBoundaryDistances();
+        }
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        auto sentNs = latencyClockNs();
+        for (std::size_t i = 0, e = m_poseBatch.size(); i < e; ++i) {
+            getSensorLatency(m_poseBatch.getSensor(i))
+                .sent.record(sentNs - m_batchQueuedNs[i]);
+        }
+        m_batchQueuedNs.clear();
 #endif
+        /// After sending, so it doesn't hold up the OSVR reports.
+        if (m_sharedPoses) {
+            publishSharedPoses();
+        }
+        m_poseBatch.clear();
+        for (auto &lastPose : m_lastPoses) {
+            lastPose.inBatch = false;
+        }
+    }
 
-        OSVR_Pose3 pose;
-        ei::map(pose.translation) =
-            (m_universeXform * worldFromDriver *
-             Eigen::Translation3d(Eigen::Vector3d::Map(newPose.vecPosition)) *
-             driverFromHeadTranslation)
-                .translation();
-        ei::map(pose.rotation) = m_universeRotation * worldFromDriverRotation *
-                                 qRotation * driverFromHeadRotation;
+    void ViveDriverHost::sendBoundaryDistances() {
+        for (std::size_t i = 0, e = m_poseBatch.size(); i < e; ++i) {
+            auto sensor = m_poseBatch.getSensor(i);
+            if (!(sensor < BOUNDARY_DISTANCE_SENSORS)) {
+                continue;
+            }
+            /// The pose is in standing universe coordinates, like the walls.
+            auto const &translation = m_poseBatch.getPose(i).translation;
+            auto distance = m_playAreaBounds->distance(translation.data[0],
+                                                       translation.data[2]);
+            auto &lastSent = m_boundaryDistancesSent[sensor];
+            /// Not true for NaN, which is what's there if nothing's been
+            /// sent.
+            if (std::abs(distance - lastSent) <= BOUNDARY_DISTANCE_DEADBAND) {
+                continue;
+            }
+            lastSent = distance;
+            osvrDeviceAnalogSetValueTimestamped(
+                m_dev, m_analog, distance, BOUNDARY_DISTANCE_ANALOG + sensor,
+                &m_poseBatch.getTimestamp(i));
+        }
+    }
 
-        auto correctedTimestamp =
-            correctTimeByOffset(tv, newPose.poseTimeOffset);
-        osvrDeviceTrackerSendPoseTimestamped(m_dev, m_tracker, &pose, sensor,
-                                             &correctedTimestamp);
+    void ViveDriverHost::publishSharedPoses() {
+        /// Only each sensor's newest pose, valid or not, with the velocities
+        /// that came with it: readers only ever see the latest, and older
+        /// entries from the batch could land on top of it.
+        for (std::size_t sensor = 0, e = m_lastPoses.size(); sensor < e;
+             ++sensor) {
+            auto &lastPose = m_lastPoses[sensor];
+            auto channel = static_cast<std::uint32_t>(sensor);
+            if (lastPose.inBatch) {
+                auto i = lastPose.batchIndex;
+                auto haveVelocity = lastPose.haveVelocity;
+                m_sharedPoses->publish(
+                    channel, m_poseBatch.getPose(i),
+                    m_poseBatch.getTimestamp(i), m_trackingResults[sensor],
+                    haveVelocity ? lastPose.linearVelocity : nullptr,
+                    haveVelocity ? lastPose.angularVelocity : nullptr);
+            } else if (lastPose.invalidToPublish) {
+                m_sharedPoses->publishInvalid(channel,
+                                              lastPose.invalidTimestamp,
+                                              m_trackingResults[sensor]);
+            }
+            lastPose.invalidToPublish = false;
+        }
     }
 
     void ViveDriverHost::handleUniverseChange(std::uint64_t newUniverse) {
@@ -557,37 +1491,103 @@ namespace vive {
         m_logger->info() << "Change of universe ID from " << m_universeId
                          << " to " << newUniverse;
         m_universeId = newUniverse;
-        auto known = m_vive->chaperone().knowUniverseId(m_universeId);
-        if (!known) {
+        applyUniverseTransform();
+    }
+
+    void ViveDriverHost::applyUniverseTransform() {
+        /// Fetch the data
+        auto univData =
+            m_chaperone ? m_chaperone->findUniverse(m_universeId) : nullptr;
+        if (!univData) {
             m_logger->info("No usable information on this universe could be "
                            "found - there may not be a calibration for it in "
                            "your room setup. You may wish to complete that "
-                           "then start the OSVR server again. Will operate "
-                           "without universe transforms.");
+                           "(then start the OSVR server again, unless "
+                           "reloadChaperone is on). Will operate without "
+                           "universe transforms.");
             m_universeXform.setIdentity();
             m_universeRotation.setIdentity();
+            setPlayAreaBounds(nullptr);
+        } else {
+            if (univData->type == osvr::vive::CalibrationType::Seated) {
+                m_logger->info("Only a seated calibration for this universe "
+                               "ID exists: y=0 will not be at floor level.");
+            }
+            using namespace Eigen;
+            /// Populate the transforms.
+            m_universeXform =
+                Translation3d(Vector3d::Map(univData->translation.data())) *
+                AngleAxisd(univData->yaw, Vector3d::UnitY());
+            m_universeRotation =
+                Quaterniond(AngleAxisd(univData->yaw, Vector3d::UnitY()));
+            setPlayAreaBounds(univData->bounds.empty() ? nullptr
+                                                       : &univData->bounds);
         }
 
-        /// Fetch the data
-        auto univData = m_vive->chaperone().getDataForUniverse(m_universeId);
-        if (univData.type == osvr::vive::CalibrationType::Seated) {
-            m_logger->info("Only a seated calibration for this universe ID "
-                           "exists: y=0 will not be at floor level.");
+        /// The cached per-sensor transforms all have the old universe
+        /// transform baked in.
+        for (auto &cache : m_transformCache) {
+            cache.valid = false;
+        }
+    }
+
+    void ViveDriverHost::setPlayAreaBounds(PlayAreaBounds const *bounds) {
+        if (bounds == m_playAreaBounds) {
+            return;
+        }
+        if (m_config.reportBoundaryDistance) {
+            if (bounds) {
+                m_logger->info("Reporting distances to the ")
+                    << bounds->size() << " walls of the play area";
+            } else {
+                m_logger->info("No play area bounds for this universe, so no "
+                               "boundary distances will be reported.");
+            }
+        }
+        m_playAreaBounds = bounds;
+        /// So the next distances are sent, whatever the deadband.
+        std::fill(begin(m_boundaryDistancesSent), end(m_boundaryDistancesSent),
+                  std::numeric_limits<double>::quiet_NaN());
+    }
+
+    void ViveDriverHost::checkChaperoneReload() {
+        if (!m_chaperoneWatcher) {
+            return;
+        }
+        auto failedReloads = m_chaperoneWatcher->getFailedReloadCount();
+        if (failedReloads != m_chaperoneFailedReloads) {
+            m_chaperoneFailedReloads = failedReloads;
+            m_logger->warn("Chaperone info file changed, but could not be "
+                           "reloaded - keeping the previous data: ")
+                << m_chaperoneWatcher->getLastFailure();
+        }
+        auto generation = m_chaperoneWatcher->generation();
+        if (generation == m_chaperoneGeneration) {
+            return;
+        }
+        m_chaperoneGeneration = generation;
+        m_chaperone = m_chaperoneWatcher->snapshot();
+        m_logger->info("Reloaded chaperone info: ")
+            << m_chaperone->getNumberOfKnownUniverses()
+            << " known universes";
+        if (m_chaperone->hasMessages()) {
+            m_logger->info("Chaperone info messages: ")
+                << m_chaperone->getMessage();
+        }
+        /// Guesses from the old data no longer count.
+        m_guessedBaseStationGeneration = 0;
+        m_guessedUniverseId = 0;
+        /// Also moves m_playAreaBounds into the new snapshot (it's only set
+        /// with a universe).
+        if (m_universeId != 0) {
+            applyUniverseTransform();
         }
-        using namespace Eigen;
-        /// Populate the transforms.
-        m_universeXform =
-            Translation3d(Vector3d::Map(univData.translation.data())) *
-            AngleAxisd(univData.yaw, Vector3d::UnitY());
-        m_universeRotation =
-            Quaterniond(AngleAxisd(univData.yaw, Vector3d::UnitY()));
     }
 
     void ViveDriverHost::TrackedDevicePoseUpdated(uint32_t unWhichDevice,
                                                   const DriverPose_t &newPose,
                                                   uint32_t unPoseStructSize) {
-        submitTrackingReport(unWhichDevice, osvr::util::time::getNow(),
-                             newPose);
+        submitTrackingReport(unWhichDevice, fastClockNs(), newPose);
     }
 
     void ViveDriverHost::ProximitySensorState(uint32_t unWhichDevice,
@@ -674,10 +1674,14 @@ namespace vive {
 
         /// If we're still around at this point, then universe contains
         /// something useful.
-        /// Check our thread-local copy of the universe ID before submitting
+        /// Check our callback-side copy of the universe ID before submitting
         /// the message.
-        if (m_trackingThreadUniverseId != universe) {
+        std::lock_guard<std::mutex> lock(m_trackingUniverseMutex);
+        auto drops = m_trackingReportDrops.load(std::memory_order_acquire);
+        if (m_trackingThreadUniverseDrops != drops ||
+            m_trackingThreadUniverseId != universe) {
             m_trackingThreadUniverseId = universe;
+            m_trackingThreadUniverseDrops = drops;
             submitUniverseChange(universe);
         }
     }
@@ -27,8 +27,19 @@
 #define INCLUDED_OSVRViveTracker_h_GUID_BDA684D2_7F2D_4483_660D_C9D679BB1F67
 
 // Internal Includes
+#include "ChaperoneWatcher.h"
+#include "ClockOffsetEstimator.h"
+#include "DriverHostConfig.h"
+#include "FastClock.h"
+#include "LatestReportTable.h"
+#include "PoseBatch.h"
 #include "QuickProcessingDeque.h"
+#include "QuickProcessingRing.h"
 #include "ReturnValue.h"
+#include "SeqlockTable.h"
+#include "SharedPosePublisher.h"
+#include "TrackingLanes.h"
+#include "TrackingReport.h"
 #include "ServerDriverHost.h"
 #include <osvr/PluginKit/AnalogInterfaceC.h>
 #include <osvr/PluginKit/ButtonInterfaceC.h>
@@ -37,12 +48,16 @@
 #include <osvr/Util/ClientReportTypesC.h>
 #include <osvr/Util/Logger.h>
 #include <osvr/Util/TimeValue.h>
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+#include "LatencyHistogram.h"
+#endif
 
 // Library/third-party includes
 #include <osvr/Util/EigenCoreGeometry.h>
 
 // Standard includes
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <iostream>
@@ -56,33 +71,73 @@ using namespace vr;
 
 namespace osvr {
 namespace vive {
-    struct TrackingReport {
-        bool isUniverseChange = false;
-        /// Only valid if isUniverseChange = true
-        std::uint64_t newUniverse;
-
-        OSVR_TimeValue timestamp;
-        OSVR_ChannelCount sensor;
-        vr::DriverPose_t report;
-    };
-
+    /// Timestamps in these are fastClockNs() readings, converted on the main
+    /// thread.
     struct ButtonReport {
-        OSVR_TimeValue timestamp;
+        std::int64_t timestampNs;
         OSVR_ChannelCount sensor;
         bool buttonState;
     };
 
     struct AnalogReport {
-        OSVR_TimeValue timestamp;
+        std::int64_t timestampNs;
         OSVR_ChannelCount sensor;
         double value;
         bool secondValid = false;
         double value2;
     };
 
+    /// @name Report queue selection
+    /// Per report type, whether the queue between the driver callbacks and
+    /// update() is the mutex-protected QuickProcessingDeque or the lock-free
+    /// QuickProcessingRing - chosen at configure time through CMake options.
+    /// @{
+#ifdef OSVRVIVE_LOCKFREE_TRACKING_QUEUE
+    using TrackingReportQueue = QuickProcessingRing<TrackingReport>;
+#else
+    using TrackingReportQueue = QuickProcessingDeque<TrackingReport>;
+#endif
+#ifdef OSVRVIVE_LOCKFREE_BUTTON_QUEUE
+    using ButtonReportQueue = QuickProcessingRing<ButtonReport>;
+#else
+    using ButtonReportQueue = QuickProcessingDeque<ButtonReport>;
+#endif
+#ifdef OSVRVIVE_LOCKFREE_ANALOG_QUEUE
+    using AnalogReportQueue = QuickProcessingRing<AnalogReport>;
+#else
+    using AnalogReportQueue = QuickProcessingDeque<AnalogReport>;
+#endif
+    /// @}
+
+    /// A device's most recent pose as the driver reported it, kept in a
+    /// SeqlockTable for readers outside the report queues.
+    struct LatestPose {
+        /// fastClockNs() of the sample - the same as the queued pose report's.
+        std::int64_t timestampNs;
+        PoseOffsets offsets;
+        /// In driver space.
+        double position[3];
+        vr::HmdQuaternion_t rotation;
+        double velocity[3];
+        double angularVelocity[3];
+        /// A vr::ETrackingResult
+        std::int32_t result;
+        bool poseIsValid;
+        bool deviceIsConnected;
+    };
+
+    /// Report queue counters as of the last time they were logged.
+    struct LoggedQueueStats {
+        std::uint64_t dropped = 0;
+        std::uint64_t overflows = 0;
+        std::size_t highWater = 0;
+    };
+
     struct NewDeviceReport {
         std::string serialNumber;
         std::uint32_t id;
+        /// A Vive Tracker (puck), which needs adding to the device descriptor.
+        bool isTracker;
     };
 
     class DriverWrapper;
@@ -90,7 +145,12 @@ namespace vive {
     class ViveDriverHost : public ServerDriverHost {
       public:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-        ViveDriverHost();
+        explicit ViveDriverHost(
+            DriverHostConfig const &config = DriverHostConfig{});
+
+        /// Stops the RunFrame thread, if any, before the members its
+        /// callbacks use go away.
+        ~ViveDriverHost();
 
         using DevIdReturnValue = ReturnValue<std::uint32_t, bool>;
         enum class StartResult { Success, TemporaryFailure, PermanentFailure };
@@ -143,6 +203,22 @@ namespace vive {
         IVRSettings *GetSettings(const char *) { return nullptr; }
         /// @}
 
+        /// Fills in the latest pose of each device, in the driver's world
+        /// space, predicted fPredictedSecondsFromNow ahead. Reads the latest
+        /// pose table, so may be called from any thread.
+        void GetRawTrackedDevicePoses(
+            float fPredictedSecondsFromNow,
+            TrackedDevicePose_t *pTrackedDevicePoseArray,
+            uint32_t unTrackedDevicePoseArrayCount) override;
+
+        /// Gets the latest pose the driver reported for a device, for
+        /// in-process consumers: callable from any thread, and never blocks
+        /// (or is blocked by) the driver's.
+        /// @return false if there's no pose for that device yet.
+        bool getLatestPose(uint32_t unWhichDevice, LatestPose &pose) const {
+            return m_latestPoses.read(unWhichDevice, pose);
+        }
+
         /// Add new Vive Tracker aka Puck to the device descriptor
         /// Called when more than 1 puck is connected
         /// todo Can be expanded to add controllers
@@ -151,9 +227,20 @@ namespace vive {
 
         void DeviceDescriptorUpdated();
 
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        /// Logs percentiles of the pose latencies recorded since the last
+        /// call, then starts over. Called periodically by update(), but can
+        /// be called any time from the main thread.
+        void logLatencyHistograms();
+#endif
+
       private:
         std::ostream &msg() const;
-        /// called from tracker thread, handles locking.
+        /// Which of the per-class options in m_config apply to a sensor.
+        SensorClassConfig const &
+        getSensorClassConfig(OSVR_ChannelCount sensor) const;
+        /// Called as base stations are activated, from whatever thread the
+        /// driver adds devices on: handles locking.
         void recordBaseStationSerial(const char *serial);
 
         /// Gets a driver pointer - may not be activated, since if it's not
@@ -193,56 +280,312 @@ namespace vive {
 
         osvr::util::log::LoggerPtr m_logger;
 
-        /// Cached copy of the universe ID only touched from tracking thread
-        /// callbacks
+        const DriverHostConfig m_config;
+
+        /// @name Tracking callback state
+        /// The driver calls back from more than one thread - its own
+        /// tracking threads, plus whichever thread runs RunFrame (the pacer,
+        /// if there is one) - so the tracking queue takes multiple
+        /// producers. It never calls back concurrently about the same
+        /// device, though, so per-device state here is owned by that
+        /// device's callbacks and sized up front (never resized); what's
+        /// shared between devices is atomic or locked.
+        /// @{
+        /// Bumped whenever the tracking queue reports a drop: with
+        /// drop-oldest, that might have been any earlier report, so state
+        /// recorded as "already queued" before the latest drop is stale.
+        std::atomic<std::uint64_t> m_trackingReportDrops{0};
+
+        /// Which devices report the universe isn't fixed, so it's locked.
+        std::mutex m_trackingUniverseMutex;
+        /// The universe ID last queued, and m_trackingReportDrops as of
+        /// then - guarded by m_trackingUniverseMutex.
         std::uint64_t m_trackingThreadUniverseId = 0;
+        std::uint64_t m_trackingThreadUniverseDrops = 0;
+
+        /// Per device, the offsets last queued.
+        struct QueuedOffsets {
+            /// false if never queued
+            bool valid = false;
+            /// m_trackingReportDrops as of queueing them (only a drop after
+            /// that can have lost them).
+            std::uint64_t drops = 0;
+            PoseOffsets offsets;
+        };
+        std::vector<QueuedOffsets> m_trackingThreadOffsets;
+        /// Per device, if filterPoseTimestamps is set.
+        std::vector<ClockOffsetEstimator> m_trackingThreadClocks;
+        /// @}
+        /// Written from the tracking callbacks, readable from anywhere.
+        SeqlockTable<LatestPose> m_latestPoses{vr::k_unMaxTrackedDeviceCount};
+        /// Called from the tracking callbacks when the tracking queue reports
+        /// a drop: with drop-oldest, that might have been any earlier report,
+        /// so every cached "already queued" state is forgotten.
+        void trackingReportDropped();
 
         /// Can be called from steamvr thread.
-        void submitTrackingReport(uint32_t unWhichDevice,
-                                  OSVR_TimeValue const &tv,
+        /// @param nowNs fastClockNs() as of the callback.
+        void submitTrackingReport(uint32_t unWhichDevice, std::int64_t nowNs,
                                   const DriverPose_t &newPose);
 
         void submitUniverseChange(std::uint64_t newUniverse);
 
+        /// Queues reports that every pose submitted after them depends on
+        /// (offsets) - in coalescing mode, flushing the waiting poses into
+        /// the queue ahead of them first.
+        /// @return false if any of them were dropped.
+        bool submitOrderedTrackingReports(TrackingReport const *reports,
+                                          std::size_t n);
+
         void submitButton(OSVR_ChannelCount sensor, bool state,
                           double eventTimeOffset = 0.);
 
+        /// @name Analog deadband - callbacks only
+        /// @{
+        /// @return true if the value should be sent on the channel, per the
+        /// deadband.
+        bool analogChanged(OSVR_ChannelCount sensor, double value) const;
+        void recordAnalogSent(OSVR_ChannelCount sensor, double value);
+        /// @}
+
         void submitAnalog(OSVR_ChannelCount sensor, double value);
         /// Submit both axes for a single mutex lock.
         void submitAnalogs(OSVR_ChannelCount sensor, double value1,
                            double value2);
 
-        /// @name Mutex-controlled
+        using TrackingLanesType =
+            TrackingLanes<TrackingReport, TrackingReportQueue>;
+
+        /// @name Mutex-controlled (unless the queue type is lock-free)
         /// @{
         std::mutex m_mutex;
-        QuickProcessingDeque<TrackingReport> m_trackingReports;
-        QuickProcessingDeque<ButtonReport> m_buttonReports;
-        QuickProcessingDeque<AnalogReport> m_analogReports;
+        /// The HMD's reports are drained and sent first, so the head pose
+        /// never waits behind controllers and pucks.
+        TrackingLanesType m_trackingLanes;
+        ButtonReportQueue m_buttonReports;
+        AnalogReportQueue m_analogReports;
         QuickProcessingDeque<NewDeviceReport> m_newDevices;
         /// @}
 
-        bool m_gotBaseStation = false;
+        /// @name Queue counters already logged - main thread only
+        /// @{
+        LoggedQueueStats m_loggedHmdTrackingQueue;
+        LoggedQueueStats m_loggedTrackingQueue;
+        LoggedQueueStats m_loggedButtonQueue;
+        LoggedQueueStats m_loggedAnalogQueue;
+        OSVR_TimeValue m_lastHighWaterLog = {0, 0};
+        /// Per sensor, in coalescing mode
+        std::vector<std::uint64_t> m_loggedCoalescedPoses;
+        OSVR_TimeValue m_lastCoalescedPoseLog = {0, 0};
+        /// @}
+
+        /// @name Analog suppression
+        /// @{
+        struct AnalogChannelState {
+            double deadband = 0.;
+            bool sent = false;
+            double value = 0.;
+        };
+        /// Per analog channel, sized up front - each channel belongs to one
+        /// device, so is only touched from that device's callbacks.
+        std::vector<AnalogChannelState> m_trackingThreadAnalogs;
+        /// Reports the deadband kept from being queued at all.
+        std::atomic<std::uint64_t> m_analogDeadbandSuppressed{0};
+
+        struct LatestAnalog {
+            bool valid = false;
+            std::int64_t timestampNs;
+            double value;
+        };
+        /// Per analog channel, filled from each drain of m_analogReports -
+        /// main thread only.
+        std::vector<LatestAnalog> m_latestAnalogs;
+        /// Reports replaced by a newer one in the same drain - main thread
+        /// only.
+        std::uint64_t m_analogCoalesced = 0;
+        std::uint64_t m_loggedAnalogDeadbandSuppressed = 0;
+        std::uint64_t m_loggedAnalogCoalesced = 0;
+        OSVR_TimeValue m_lastAnalogSuppressionLog = {0, 0};
+        void setLatestAnalog(OSVR_ChannelCount sensor, double value,
+                             std::int64_t timestampNs);
+        /// Periodically logs how many analog reports weren't sent.
+        void logAnalogSuppression();
+        /// @}
+
+        /// Set by whichever thread the driver adds devices from.
+        std::atomic<bool> m_haveHmd{false};
+        /// Main thread only, when the RunFrame thread is in use.
+        OSVR_TimeValue m_lastRunFrameStatsLog = {0, 0};
         /// @name Base station serials (mutex controlled)
         /// @{
         std::mutex m_baseStationMutex;
+        /// Sorted, no duplicates.
         std::vector<std::string> m_baseStationSerials;
         /// @}
+        /// Bumped (under the mutex) each time a new serial is added, so 0
+        /// means none have been seen - readable without the lock.
+        std::atomic<std::uint64_t> m_baseStationGeneration{0};
+        /// @name Universe guessing (main thread only)
+        /// @{
+        /// The m_baseStationGeneration the last guess was made from.
+        std::uint64_t m_guessedBaseStationGeneration = 0;
+        /// Result of the last guess, 0 if it couldn't.
+        std::uint64_t m_guessedUniverseId = 0;
+        /// @}
 
         /// @name Main-thread only
         /// @{
         /// Current reports - main thread only
         /// Called from main thread only!
-        void convertAndSendTracker(OSVR_TimeValue const &tv,
-                                   OSVR_ChannelCount sensor,
-                                   const DriverPose_t &newPose);
+        /// Gets the cached transforms for this sensor, refreshing them first
+        /// if needed.
+        /// @return nullptr if we haven't gotten this sensor's offsets yet.
+        SensorTransformCache const *getTransformCache(OSVR_ChannelCount sensor);
+        /// Records new WorldFromDriver/DriverFromHead offsets for a sensor.
+        void handleOffsetsReport(TrackingReport const &report);
+        /// Dispatches one report from the tracking queue or table.
+        void handleTrackingReport(TrackingReport const &report);
+        /// Adds a pose to m_poseBatch (if valid) - nothing is sent until
+        /// sendTrackerBatch().
+        void batchTracker(TrackingReport const &report);
+        /// Uses a velocity record to predict the pose it came with (if that's
+        /// still in the batch) and/or sends it.
+        void handleVelocityReport(TrackingReport const &report);
+        /// Sends a velocity or acceleration record along with the pose it
+        /// came with: after it, if that's still in the batch.
+        void handleMotionReport(TrackingReport const &report);
+        /// Rotates a velocity or acceleration record into the universe and
+        /// sends it, with the timestamp of the pose it came with.
+        /// @param incrementDt Time step for the incremental rotation.
+        void sendMotion(TrackingReport const &report,
+                        OSVR_TimeValue const &timestamp, double incrementDt);
+        /// Converts and sends all poses in m_poseBatch, then empties it.
+        void sendTrackerBatch();
         void handleUniverseChange(std::uint64_t newUniverse);
+        /// Sets the universe transforms from the chaperone data for
+        /// m_universeId.
+        void applyUniverseTransform();
+        /// Switches to reporting distances to these walls (or, given
+        /// nullptr, stops).
+        void setPlayAreaBounds(PlayAreaBounds const *bounds);
+        /// Sends each sensor's distance from the nearest wall, for the
+        /// poses in m_poseBatch (after conversion).
+        void sendBoundaryDistances();
+        /// Picks up a reloaded chaperone snapshot, if there's a new one.
+        void checkChaperoneReload();
+        /// Periodically logs how many poses coalescing mode dropped.
+        void logCoalescedPoses();
+        /// Logs (and resets) the timing statistics of the RunFrame thread.
+        void logRunFrameStats();
 
         OSVR_PluginRegContext m_ctx;
 
         std::uint64_t m_universeId = 0;
+        /// The last universe change report handled, to skip the other
+        /// lane's copy of it.
+        bool m_handledUniverseChange = false;
+        std::uint64_t m_lastUniverseChange = 0;
+        /// @name Chaperone data (main thread only)
+        /// @{
+        /// The snapshot in use.
+        std::shared_ptr<ChaperoneData> m_chaperone;
+        /// If configured, replaces m_chaperone when the file changes.
+        std::unique_ptr<ChaperoneWatcher> m_chaperoneWatcher;
+        std::uint64_t m_chaperoneGeneration = 0;
+        std::uint64_t m_chaperoneFailedReloads = 0;
+        /// The current universe's walls, if it has any - points into
+        /// m_chaperone.
+        PlayAreaBounds const *m_playAreaBounds = nullptr;
+        /// Per sensor, the boundary distance last sent (NaN if none since
+        /// the bounds changed).
+        std::vector<double> m_boundaryDistancesSent;
+        /// @}
         Eigen::Isometry3d m_universeXform;
         Eigen::Quaterniond m_universeRotation;
         std::vector<vr::ETrackingResult> m_trackingResults;
+        /// Per sensor - offsets filled in by handleOffsetsReport, transforms
+        /// invalidated by that and by handleUniverseChange.
+        std::vector<SensorTransformCache,
+                    Eigen::aligned_allocator<SensorTransformCache>>
+            m_transformCache;
+        /// Poses waiting to be converted and sent - all of them use the
+        /// current universe transform.
+        PoseBatch m_poseBatch;
+        /// Per sensor, about the last pose record handled.
+        struct LastPose {
+            /// false if the pose wasn't valid, so nothing was sent.
+            bool batched = false;
+            OSVR_TimeValue timestamp;
+            std::int64_t timestampNs = 0;
+            /// Whether it's still in m_poseBatch (at batchIndex), so it can
+            /// still be predicted.
+            bool inBatch = false;
+            std::size_t batchIndex = 0;
+            /// Its driver space rotation (w, x, y, z), which places the head
+            /// offset its velocities need.
+            float rotation[4];
+            /// Room space velocities that came with it, for the shared
+            /// poses.
+            bool haveVelocity = false;
+            double linearVelocity[3];
+            double angularVelocity[3];
+            /// Time step for angular rates that come with it: the interval
+            /// since the sensor's previous pose, within limits.
+            double incrementDt = 0.;
+            /// The newest pose wasn't valid, and the shared poses haven't
+            /// been told yet.
+            bool invalidToPublish = false;
+            OSVR_TimeValue invalidTimestamp;
+        };
+        std::vector<LastPose> m_lastPoses;
+        /// Velocity and acceleration records for poses in m_poseBatch,
+        /// sent right after the batch so clients never get motion ahead of
+        /// its pose.
+        struct PendingMotion {
+            TrackingReport report;
+            std::size_t batchIndex;
+            double incrementDt;
+        };
+        std::vector<PendingMotion> m_pendingMotion;
+        /// If configured - main thread only.
+        std::unique_ptr<SharedPosePublisher> m_sharedPoses;
+        /// Publishes each sensor's newest pose from the batch just sent -
+        /// or that its newest wasn't valid.
+        void publishSharedPoses();
+        /// Per sensor, the latest latency estimate (microseconds) that came
+        /// with a pose, if filterPoseTimestamps is set.
+        std::vector<std::int32_t> m_transportLatencyUs;
+        OSVR_TimeValue m_lastTransportLatencyLog = {0, 0};
+        /// Periodically logs m_transportLatencyUs.
+        void logTransportLatency();
+        /// Recalibrated each time a batch of reports is about to be sent,
+        /// then used to convert their timestamps.
+        FastClockCalibration m_clock;
+        /// When the current batch started sending (as of the last calibration)
+        /// - predictions are relative to this.
+        OSVR_TimeValue m_sendTime = {0, 0};
+        std::int64_t m_sendNs = 0;
+        /// Recalibrates m_clock, and sets m_sendTime and m_sendNs.
+        void latchSendTime();
+
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        /// @name Latency instrumentation
+        /// @{
+        struct SensorLatency {
+            /// From TrackedDevicePoseUpdated until update() grabbed it.
+            LatencyHistogram grabbed;
+            /// From TrackedDevicePoseUpdated until it was sent.
+            LatencyHistogram sent;
+        };
+        SensorLatency &getSensorLatency(OSVR_ChannelCount sensor);
+        std::vector<SensorLatency> m_latency;
+        /// queuedNs of each pose in m_poseBatch, by index.
+        std::vector<std::int64_t> m_batchQueuedNs;
+        /// When this update() grabbed the reports.
+        std::int64_t m_grabNs = 0;
+        OSVR_TimeValue m_lastLatencyLog = {0, 0};
+        /// @}
+#endif
 
         std::uint32_t m_puckIdx;
         std::string m_devDescriptor;
@@ -0,0 +1,160 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_PlayAreaBounds_h_GUID_5E2B9C70_4D1F_4A83_B6E9_07C3F58A1D26
+#define INCLUDED_PlayAreaBounds_h_GUID_5E2B9C70_4D1F_4A83_B6E9_07C3F58A1D26
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace osvr {
+namespace vive {
+    namespace detail {
+        /// Where padding segments are: far enough to never be the nearest,
+        /// close enough that squaring the distance doesn't overflow.
+        static const double PLAY_AREA_PADDING_POSITION = 1e30;
+    } // namespace detail
+
+    /// The walls of a play area (the chaperone's collision bounds), as line
+    /// segments on the floor - the XZ plane of the standing universe - for
+    /// finding how far a tracked point is from the nearest one.
+    ///
+    /// The segments are stored as structure-of-arrays, padded to a multiple
+    /// of LANES with segments too far away to ever be nearest, so the
+    /// distance query works on blocks of LANES segments at a time with
+    /// straight-line arithmetic the compiler vectorizes to whatever the
+    /// target instruction set allows (SSE2/AVX/NEON), with no tail to
+    /// handle.
+    class PlayAreaBounds {
+      public:
+        /// Segments processed side by side.
+        static const std::size_t LANES = 4;
+
+        bool empty() const { return numSegments_ == 0; }
+        /// Number of segments added (not counting padding).
+        std::size_t size() const { return numSegments_; }
+
+        /// Adds a wall from (x0, z0) to (x1, z1).
+        void addSegment(double x0, double z0, double x1, double z1) {
+            auto dx = x1 - x0;
+            auto dz = z1 - z0;
+            auto lenSq = dx * dx + dz * dz;
+            auto i = numSegments_++;
+            if (i == ax_.size()) {
+                /// Out of padding: add another LANES worth.
+                for (std::size_t lane = 0; lane < LANES; ++lane) {
+                    ax_.push_back(detail::PLAY_AREA_PADDING_POSITION);
+                    az_.push_back(detail::PLAY_AREA_PADDING_POSITION);
+                    dx_.push_back(0.);
+                    dz_.push_back(0.);
+                    invLenSq_.push_back(0.);
+                }
+            }
+            ax_[i] = x0;
+            az_[i] = z0;
+            dx_[i] = dx;
+            dz_[i] = dz;
+            /// A zero-length segment is just its start point.
+            invLenSq_[i] = lenSq > 0. ? 1. / lenSq : 0.;
+        }
+
+        /// Adds the edges of an axis-aligned rectangle centered on the
+        /// origin - the shape of the chaperone's "play_area".
+        void addCenteredRectangle(double width, double depth) {
+            auto x = width / 2.;
+            auto z = depth / 2.;
+            addSegment(-x, -z, x, -z);
+            addSegment(x, -z, x, z);
+            addSegment(x, z, -x, z);
+            addSegment(-x, z, -x, -z);
+        }
+
+        /// Distance (in the floor plane) from (x, z) to the nearest wall, or
+        /// infinity if there are none.
+        double distance(double x, double z) const {
+            auto ax = ax_.data();
+            auto az = az_.data();
+            auto dx = dx_.data();
+            auto dz = dz_.data();
+            auto invLenSq = invLenSq_.data();
+            auto best = std::numeric_limits<double>::infinity();
+            for (std::size_t i = 0, e = ax_.size(); i < e; i += LANES) {
+                /// Comparison-free (so vectorizable without relaxed floating
+                /// point flags) squared distance to each segment in the block.
+                double distSq[LANES];
+                for (std::size_t lane = 0; lane < LANES; ++lane) {
+                    auto j = i + lane;
+                    auto px = x - ax[j];
+                    auto pz = z - az[j];
+                    /// Fraction along the segment of the closest point,
+                    /// clamped to [0, 1] as (|t| - |t - 1| + 1) / 2.
+                    auto t = (px * dx[j] + pz * dz[j]) * invLenSq[j];
+                    t = 0.5 * (std::fabs(t) - std::fabs(t - 1.) + 1.);
+                    auto ex = px - t * dx[j];
+                    auto ez = pz - t * dz[j];
+                    distSq[lane] = ex * ex + ez * ez;
+                }
+                for (std::size_t lane = 0; lane < LANES; ++lane) {
+                    best = distSq[lane] < best ? distSq[lane] : best;
+                }
+            }
+            return std::sqrt(best);
+        }
+
+        /// @name Segment access
+        /// @{
+        double startX(std::size_t i) const { return ax_[i]; }
+        double startZ(std::size_t i) const { return az_[i]; }
+        double endX(std::size_t i) const { return ax_[i] + dx_[i]; }
+        double endZ(std::size_t i) const { return az_[i] + dz_[i]; }
+        /// @}
+
+      private:
+        std::size_t numSegments_ = 0;
+        /// @name Per segment, padded to a multiple of LANES
+        /// @{
+        /// Start point
+        std::vector<double> ax_;
+        std::vector<double> az_;
+        /// End point minus start point
+        std::vector<double> dx_;
+        std::vector<double> dz_;
+        /// 1 / squared length, or 0 for zero length (and padding)
+        std::vector<double> invLenSq_;
+        /// @}
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_PlayAreaBounds_h_GUID_5E2B9C70_4D1F_4A83_B6E9_07C3F58A1D26
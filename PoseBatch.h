@@ -0,0 +1,449 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_PoseBatch_h_GUID_0B6E3F7D_58A2_4C19_8D4E_F2A7C9B1E064
+#define INCLUDED_PoseBatch_h_GUID_0B6E3F7D_58A2_4C19_8D4E_F2A7C9B1E064
+
+// Internal Includes
+#include "PosePrediction.h"
+#include <osvr/Util/ClientReportTypesC.h>
+#include <osvr/Util/TimeValue.h>
+
+// Library/third-party includes
+#include <openvr_driver.h>
+#include <osvr/Util/EigenCoreGeometry.h>
+
+// Standard includes
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+/// Non-aliasing pointer qualifier, spelled the way all our compilers accept.
+#define OSVRVIVE_RESTRICT __restrict
+
+namespace osvr {
+namespace vive {
+    /// The parts of a DriverPose_t that place the driver's tracking space
+    /// (and the "head" of the device) - they almost never change for a given
+    /// device, so they're compared bitwise to detect when they do.
+    struct PoseOffsets {
+        vr::HmdQuaternion_t qWorldFromDriverRotation;
+        double vecWorldFromDriverTranslation[3];
+        vr::HmdQuaternion_t qDriverFromHeadRotation;
+        double vecDriverFromHeadTranslation[3];
+    };
+
+    inline PoseOffsets getPoseOffsets(vr::DriverPose_t const &pose) {
+        PoseOffsets ret;
+        ret.qWorldFromDriverRotation = pose.qWorldFromDriverRotation;
+        std::copy_n(pose.vecWorldFromDriverTranslation, 3,
+                    ret.vecWorldFromDriverTranslation);
+        ret.qDriverFromHeadRotation = pose.qDriverFromHeadRotation;
+        std::copy_n(pose.vecDriverFromHeadTranslation, 3,
+                    ret.vecDriverFromHeadTranslation);
+        return ret;
+    }
+
+    inline bool operator==(PoseOffsets const &a, PoseOffsets const &b) {
+        /// Bitwise on purpose: it's plain doubles with no padding, and we only
+        /// care whether the driver sent us exactly the same thing.
+        return 0 == std::memcmp(&a, &b, sizeof(PoseOffsets));
+    }
+
+    inline Eigen::Quaterniond quatFromSteamVR(vr::HmdQuaternion_t const &q) {
+        return Eigen::Quaterniond(q.w, q.x, q.y, q.z);
+    }
+
+    /// Transforms derived from a sensor's PoseOffsets and the current
+    /// universe transform, so converting a pose is just a quaternion multiply
+    /// and a vector transform.
+    struct SensorTransformCache {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        /// Whether the transforms below are up to date.
+        bool valid = false;
+        /// Whether each half of offsets has been received.
+        bool haveWorldFromDriver = false;
+        bool haveDriverFromHead = false;
+        PoseOffsets offsets;
+        /// universe * worldFromDriver
+        Eigen::Quaterniond universeFromDriverRotation;
+        Eigen::Matrix3d universeFromDriverLinear;
+        Eigen::Vector3d universeFromDriverTranslation;
+        /// driverFromHead
+        Eigen::Quaterniond driverFromHeadRotation;
+        Eigen::Vector3d driverFromHeadTranslation;
+    };
+
+    /// Derives the transforms in @p cache from its offsets and the universe
+    /// transform (the same transform both ways, as an isometry and just its
+    /// rotation), and marks it valid.
+    inline void
+    computeSensorTransforms(Eigen::Isometry3d const &universeXform,
+                            Eigen::Quaterniond const &universeRotation,
+                            SensorTransformCache &cache) {
+        using namespace Eigen;
+        auto const &offsets = cache.offsets;
+        auto worldFromDriverRotation =
+            quatFromSteamVR(offsets.qWorldFromDriverRotation);
+        Translation3d worldFromDriverTranslation(
+            Vector3d::Map(offsets.vecWorldFromDriverTranslation));
+        Isometry3d worldFromDriver =
+            worldFromDriverTranslation * worldFromDriverRotation;
+        Isometry3d universeFromDriver = universeXform * worldFromDriver;
+
+        cache.universeFromDriverRotation =
+            universeRotation * worldFromDriverRotation;
+        cache.universeFromDriverLinear = universeFromDriver.linear();
+        cache.universeFromDriverTranslation = universeFromDriver.translation();
+        cache.driverFromHeadRotation =
+            quatFromSteamVR(offsets.qDriverFromHeadRotation);
+        cache.driverFromHeadTranslation =
+            Vector3d::Map(offsets.vecDriverFromHeadTranslation);
+        cache.valid = true;
+    }
+
+    /// Converts one pose the same way PoseBatch::convert() does a batch:
+    /// the translation universeFromDriver * (position + rotation *
+    /// driverFromHeadTranslation) - the head offset is in the device's own
+    /// frame - and the rotation
+    /// universeFromDriverRotation * rotation * driverFromHeadRotation.
+    inline void convertPose(SensorTransformCache const &xforms,
+                            Eigen::Vector3d const &position,
+                            Eigen::Quaterniond const &rotation,
+                            Eigen::Vector3d &outPosition,
+                            Eigen::Quaterniond &outRotation) {
+        outPosition =
+            xforms.universeFromDriverLinear *
+                (position + rotation * xforms.driverFromHeadTranslation) +
+            xforms.universeFromDriverTranslation;
+        outRotation = xforms.universeFromDriverRotation * rotation *
+                      xforms.driverFromHeadRotation;
+    }
+
+    /// The linear velocity of the head - the point convertPose() places -
+    /// from the driver's velocities, which are of its tracked point: adds
+    /// the lever arm, angularVelocity x (rotation *
+    /// driverFromHeadTranslation). All in driver space.
+    inline Eigen::Vector3d
+    headLinearVelocity(Eigen::Vector3d const &linearVelocity,
+                       Eigen::Vector3d const &angularVelocity,
+                       Eigen::Quaterniond const &rotation,
+                       Eigen::Vector3d const &driverFromHeadTranslation) {
+        return linearVelocity +
+               angularVelocity.cross(rotation * driverFromHeadTranslation);
+    }
+
+    /// A batch of poses laid out as structure-of-arrays - positions,
+    /// rotations, and the transforms to apply to each in separate arrays - so
+    /// the whole batch can be converted to OSVR poses in one pass that the
+    /// compiler can vectorize.
+    class PoseBatch {
+      public:
+        void clear() {
+            sensors_.clear();
+            timestamps_.clear();
+            poses_.clear();
+            predictions_.clear();
+        }
+
+        bool empty() const { return sensors_.empty(); }
+        std::size_t size() const { return sensors_.size(); }
+
+        /// Append a pose, with the (already time-corrected) timestamp to send
+        /// it with and the cached transforms for its sensor.
+        /// @param position x, y, z in driver space
+        /// @param rotation w, x, y, z in driver space
+        void add(OSVR_ChannelCount sensor, OSVR_TimeValue const &timestamp,
+                 const double position[3], const float rotation[4],
+                 SensorTransformCache const &xforms) {
+            auto i = size();
+            if (i == stride_) {
+                grow();
+            }
+            sensors_.push_back(sensor);
+            timestamps_.push_back(timestamp);
+            for (int c = 0; c < 3; ++c) {
+                input(PX + c, i) = position[c];
+                input(DTX + c, i) = xforms.driverFromHeadTranslation[c];
+                input(UTX + c, i) = xforms.universeFromDriverTranslation[c];
+                for (int j = 0; j < 3; ++j) {
+                    input(U00 + 3 * c + j, i) =
+                        xforms.universeFromDriverLinear(c, j);
+                }
+            }
+            setQuat(QW, i, rotation[0], rotation[1], rotation[2], rotation[3]);
+            setQuat(DQW, i, xforms.driverFromHeadRotation);
+            setQuat(UQW, i, xforms.universeFromDriverRotation);
+        }
+
+        /// Have convert() extrapolate an added pose to a later time.
+        /// @param i index of the pose in the batch
+        /// @param linearVelocity driver space, of the driver's tracked point
+        /// (the head's is worked out from it)
+        /// @param angularVelocity driver space, axis-angle
+        /// @param target time to extrapolate to, and send the pose with.
+        void predict(std::size_t i, const double linearVelocity[3],
+                     const double angularVelocity[3],
+                     OSVR_TimeValue const &target) {
+            Prediction p;
+            p.index = i;
+            p.linearVelocity = Eigen::Vector3d::Map(linearVelocity);
+            p.angularVelocity = Eigen::Vector3d::Map(angularVelocity);
+            p.target = target;
+            predictions_.push_back(p);
+        }
+
+        /// Converts every pose in the batch: the translation of
+        /// universeFromDriver * Translation(position) * rotation *
+        /// driverFromHeadTranslation, and the rotation
+        /// universeFromDriverRotation * rotation * driverFromHeadRotation.
+        void convert() {
+            auto n = size();
+            convertKernel(n, stride_, in_.data(), out_.data());
+            poses_.resize(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                auto &pose = poses_[i];
+                for (int c = 0; c < 3; ++c) {
+                    pose.translation.data[c] = out_[(OUT_TX + c) * stride_ + i];
+                }
+                for (int c = 0; c < 4; ++c) {
+                    pose.rotation.data[c] = out_[(OUT_QW + c) * stride_ + i];
+                }
+            }
+            applyPredictions();
+        }
+
+        /// @name Results - valid after convert()
+        /// @{
+        OSVR_ChannelCount getSensor(std::size_t i) const {
+            return sensors_[i];
+        }
+        OSVR_TimeValue const &getTimestamp(std::size_t i) const {
+            return timestamps_[i];
+        }
+        OSVR_Pose3 const &getPose(std::size_t i) const { return poses_[i]; }
+        /// @}
+
+      private:
+        /// Indices of the input component arrays.
+        enum InputComponent {
+            /// position
+            PX, PY, PZ,
+            /// rotation
+            QW, QX, QY, QZ,
+            /// driverFromHead
+            DTX, DTY, DTZ,
+            DQW, DQX, DQY, DQZ,
+            /// universeFromDriver, linear part row-major
+            U00, U01, U02, U10, U11, U12, U20, U21, U22,
+            UTX, UTY, UTZ,
+            UQW, UQX, UQY, UQZ,
+            NUM_INPUT_COMPONENTS
+        };
+        /// Indices of the output component arrays.
+        enum OutputComponent {
+            OUT_TX, OUT_TY, OUT_TZ,
+            OUT_QW, OUT_QX, OUT_QY, OUT_QZ,
+            NUM_OUTPUT_COMPONENTS
+        };
+
+        static const std::size_t INITIAL_STRIDE = 16;
+
+        struct Prediction {
+            std::size_t index;
+            Eigen::Vector3d linearVelocity;
+            Eigen::Vector3d angularVelocity;
+            OSVR_TimeValue target;
+        };
+
+        /// Extrapolates the converted poses that have a prediction -
+        /// velocities are rotated into the universe first, which makes this
+        /// the same as predicting before the conversion.
+        void applyPredictions() {
+            for (auto const &p : predictions_) {
+                auto i = p.index;
+                auto &pose = poses_[i];
+                Eigen::Quaterniond universeFromDriverRotation(
+                    in_[UQW * stride_ + i], in_[UQX * stride_ + i],
+                    in_[UQY * stride_ + i], in_[UQZ * stride_ + i]);
+                auto dt = osvrTimeValueDurationSeconds(&p.target,
+                                                       &timestamps_[i]);
+                /// The head swings around the tracked point as it turns: the
+                /// lever arm, angularVelocity x headOffset, taken as the
+                /// chord over dt so it stays on the arc (what
+                /// headLinearVelocity() gives as dt goes to 0).
+                Eigen::Quaterniond driverRotation(
+                    in_[QW * stride_ + i], in_[QX * stride_ + i],
+                    in_[QY * stride_ + i], in_[QZ * stride_ + i]);
+                Eigen::Vector3d headOffset =
+                    driverRotation * Eigen::Vector3d(in_[DTX * stride_ + i],
+                                                     in_[DTY * stride_ + i],
+                                                     in_[DTZ * stride_ + i]);
+                Eigen::Vector3d linearVelocity = p.linearVelocity;
+                if (dt > 0) {
+                    linearVelocity +=
+                        (quatExp(p.angularVelocity * (dt / 2.)) * headOffset -
+                         headOffset) /
+                        dt;
+                }
+                Eigen::Vector3d position =
+                    Eigen::Vector3d::Map(pose.translation.data);
+                Eigen::Quaterniond rotation(
+                    pose.rotation.data[0], pose.rotation.data[1],
+                    pose.rotation.data[2], pose.rotation.data[3]);
+                predictPose(position, rotation,
+                            universeFromDriverRotation * linearVelocity,
+                            universeFromDriverRotation * p.angularVelocity,
+                            dt);
+                Eigen::Vector3d::Map(pose.translation.data) = position;
+                pose.rotation.data[0] = rotation.w();
+                pose.rotation.data[1] = rotation.x();
+                pose.rotation.data[2] = rotation.y();
+                pose.rotation.data[3] = rotation.z();
+                timestamps_[i] = p.target;
+            }
+        }
+
+        double &input(int component, std::size_t i) {
+            return in_[component * stride_ + i];
+        }
+
+        void setQuat(int first, std::size_t i, double w, double x, double y,
+                     double z) {
+            input(first, i) = w;
+            input(first + 1, i) = x;
+            input(first + 2, i) = y;
+            input(first + 3, i) = z;
+        }
+        void setQuat(int first, std::size_t i, Eigen::Quaterniond const &q) {
+            setQuat(first, i, q.w(), q.x(), q.y(), q.z());
+        }
+
+        /// Double the room for each component, keeping what's been added.
+        void grow() {
+            auto newStride = stride_ == 0 ? INITIAL_STRIDE : stride_ * 2;
+            std::vector<double> newIn(NUM_INPUT_COMPONENTS * newStride);
+            for (std::size_t c = 0; c < NUM_INPUT_COMPONENTS; ++c) {
+                std::copy_n(in_.begin() + c * stride_, size(),
+                            newIn.begin() + c * newStride);
+            }
+            in_.swap(newIn);
+            out_.resize(NUM_OUTPUT_COMPONENTS * newStride);
+            stride_ = newStride;
+        }
+
+        /// The actual work: straight-line arithmetic over component arrays
+        /// (each @p stride long) with no aliasing between input and output,
+        /// so each loop vectorizes to whatever the target instruction set
+        /// allows (SSE2/AVX/NEON), and is plain scalar code elsewhere.
+        static void convertKernel(std::size_t n, std::size_t stride,
+                                  const double *OSVRVIVE_RESTRICT in,
+                                  double *OSVRVIVE_RESTRICT out) {
+            auto px = in + PX * stride;
+            auto py = in + PY * stride;
+            auto pz = in + PZ * stride;
+            auto qw = in + QW * stride;
+            auto qx = in + QX * stride;
+            auto qy = in + QY * stride;
+            auto qz = in + QZ * stride;
+            auto dtx = in + DTX * stride;
+            auto dty = in + DTY * stride;
+            auto dtz = in + DTZ * stride;
+            auto dqw = in + DQW * stride;
+            auto dqx = in + DQX * stride;
+            auto dqy = in + DQY * stride;
+            auto dqz = in + DQZ * stride;
+            auto u00 = in + U00 * stride;
+            auto u01 = in + U01 * stride;
+            auto u02 = in + U02 * stride;
+            auto u10 = in + U10 * stride;
+            auto u11 = in + U11 * stride;
+            auto u12 = in + U12 * stride;
+            auto u20 = in + U20 * stride;
+            auto u21 = in + U21 * stride;
+            auto u22 = in + U22 * stride;
+            auto utx = in + UTX * stride;
+            auto uty = in + UTY * stride;
+            auto utz = in + UTZ * stride;
+            auto uqw = in + UQW * stride;
+            auto uqx = in + UQX * stride;
+            auto uqy = in + UQY * stride;
+            auto uqz = in + UQZ * stride;
+            auto tx = out + OUT_TX * stride;
+            auto ty = out + OUT_TY * stride;
+            auto tz = out + OUT_TZ * stride;
+            auto rw = out + OUT_QW * stride;
+            auto rx = out + OUT_QX * stride;
+            auto ry = out + OUT_QY * stride;
+            auto rz = out + OUT_QZ * stride;
+
+            /// Translation: position + rotation * driverFromHeadTranslation
+            /// (as t + w * c + q x c, with c = 2 * q x t), then
+            /// universeFromDriver.
+            for (std::size_t i = 0; i < n; ++i) {
+                auto cx = 2. * (qy[i] * dtz[i] - qz[i] * dty[i]);
+                auto cy = 2. * (qz[i] * dtx[i] - qx[i] * dtz[i]);
+                auto cz = 2. * (qx[i] * dty[i] - qy[i] * dtx[i]);
+                auto x = px[i] + dtx[i] + qw[i] * cx + qy[i] * cz - qz[i] * cy;
+                auto y = py[i] + dty[i] + qw[i] * cy + qz[i] * cx - qx[i] * cz;
+                auto z = pz[i] + dtz[i] + qw[i] * cz + qx[i] * cy - qy[i] * cx;
+                tx[i] = u00[i] * x + u01[i] * y + u02[i] * z + utx[i];
+                ty[i] = u10[i] * x + u11[i] * y + u12[i] * z + uty[i];
+                tz[i] = u20[i] * x + u21[i] * y + u22[i] * z + utz[i];
+            }
+
+            /// Rotation: (universeFromDriver * rotation) * driverFromHead,
+            /// both Hamilton products, same order as Eigen evaluates them.
+            for (std::size_t i = 0; i < n; ++i) {
+                auto w = uqw[i] * qw[i] - uqx[i] * qx[i] - uqy[i] * qy[i] -
+                         uqz[i] * qz[i];
+                auto x = uqw[i] * qx[i] + uqx[i] * qw[i] + uqy[i] * qz[i] -
+                         uqz[i] * qy[i];
+                auto y = uqw[i] * qy[i] + uqy[i] * qw[i] + uqz[i] * qx[i] -
+                         uqx[i] * qz[i];
+                auto z = uqw[i] * qz[i] + uqz[i] * qw[i] + uqx[i] * qy[i] -
+                         uqy[i] * qx[i];
+                rw[i] = w * dqw[i] - x * dqx[i] - y * dqy[i] - z * dqz[i];
+                rx[i] = w * dqx[i] + x * dqw[i] + y * dqz[i] - z * dqy[i];
+                ry[i] = w * dqy[i] + y * dqw[i] + z * dqx[i] - x * dqz[i];
+                rz[i] = w * dqz[i] + z * dqw[i] + x * dqy[i] - y * dqx[i];
+            }
+        }
+
+        std::vector<OSVR_ChannelCount> sensors_;
+        std::vector<OSVR_TimeValue> timestamps_;
+        /// Number of elements reserved per component array.
+        std::size_t stride_ = 0;
+        /// Component arrays, back to back, each stride_ long.
+        std::vector<double> in_;
+        std::vector<double> out_;
+        std::vector<OSVR_Pose3> poses_;
+        std::vector<Prediction> predictions_;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_PoseBatch_h_GUID_0B6E3F7D_58A2_4C19_8D4E_F2A7C9B1E064
@@ -0,0 +1,72 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_PosePrediction_h_GUID_9D41C7A2_3E85_4B6F_A0D2_71F5E8B93C46
+#define INCLUDED_PosePrediction_h_GUID_9D41C7A2_3E85_4B6F_A0D2_71F5E8B93C46
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+#include <osvr/Util/EigenCoreGeometry.h>
+
+// Standard includes
+#include <cmath>
+
+namespace osvr {
+namespace vive {
+    /// The quaternion exponential of a pure quaternion given as a vector:
+    /// the rotation by |v| * 2 radians about v.
+    inline Eigen::Quaterniond quatExp(Eigen::Vector3d const &v) {
+        auto theta = v.norm();
+        if (theta < 1e-12) {
+            /// First-order approximation, normalized - avoids dividing by
+            /// (nearly) zero.
+            return Eigen::Quaterniond(1., v.x(), v.y(), v.z()).normalized();
+        }
+        auto scale = std::sin(theta) / theta;
+        return Eigen::Quaterniond(std::cos(theta), v.x() * scale,
+                                  v.y() * scale, v.z() * scale);
+    }
+
+    /// Extrapolates a pose forward by dt seconds assuming constant velocity.
+    ///
+    /// @param linearVelocity meters/second, in the same frame as position.
+    /// @param angularVelocity axis-angle rate (radians/second), in the same
+    /// frame as the pose (not the body frame) - so it's integrated as
+    /// rotation = exp(angularVelocity * dt / 2) * rotation.
+    inline void predictPose(Eigen::Vector3d &position,
+                            Eigen::Quaterniond &rotation,
+                            Eigen::Vector3d const &linearVelocity,
+                            Eigen::Vector3d const &angularVelocity,
+                            double dt) {
+        position += linearVelocity * dt;
+        rotation = (quatExp(angularVelocity * (dt / 2.)) * rotation)
+                       .normalized();
+    }
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_PosePrediction_h_GUID_9D41C7A2_3E85_4B6F_A0D2_71F5E8B93C46
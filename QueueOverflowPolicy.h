@@ -0,0 +1,90 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_QueueOverflowPolicy_h_GUID_0B7D3E91_5A26_4C8F_B4E3_92F1C6A08D57
+#define INCLUDED_QueueOverflowPolicy_h_GUID_0B7D3E91_5A26_4C8F_B4E3_92F1C6A08D57
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstddef>
+#include <string>
+
+namespace osvr {
+namespace vive {
+    /// What a bounded report queue does with a submission when it's full.
+    enum class QueueOverflowPolicy {
+        /// Discard the oldest waiting item to make room: for reports where
+        /// only the recent past matters, like poses.
+        DropOldest,
+        /// Discard the new item.
+        DropNewest,
+        /// Keep everything, growing past the capacity (which then only
+        /// sizes the up-front allocation and triggers the overflow count):
+        /// for reports that must not be lost, like button presses.
+        NeverDrop
+    };
+
+    /// Capacity and policy for one report queue.
+    struct QueueConfig {
+        /// 0 means unbounded (the policy is then irrelevant).
+        std::size_t capacity;
+        QueueOverflowPolicy overflow;
+    };
+
+    inline const char *toString(QueueOverflowPolicy policy) {
+        switch (policy) {
+        case QueueOverflowPolicy::DropOldest:
+            return "dropOldest";
+        case QueueOverflowPolicy::DropNewest:
+            return "dropNewest";
+        case QueueOverflowPolicy::NeverDrop:
+            return "neverDrop";
+        }
+        return "unknown";
+    }
+
+    /// Parses the names returned by toString().
+    /// @return false (leaving policy untouched) if unrecognized.
+    inline bool parseQueueOverflowPolicy(std::string const &name,
+                                         QueueOverflowPolicy &policy) {
+        for (auto candidate : {QueueOverflowPolicy::DropOldest,
+                               QueueOverflowPolicy::DropNewest,
+                               QueueOverflowPolicy::NeverDrop}) {
+            if (name == toString(candidate)) {
+                policy = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_QueueOverflowPolicy_h_GUID_0B7D3E91_5A26_4C8F_B4E3_92F1C6A08D57
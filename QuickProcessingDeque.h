@@ -26,14 +26,17 @@
 #define INCLUDED_QuickProcessingDeque_h_GUID_B6819891_863F_4B8A_9024_C0E42E1D21AA
 
 // Internal Includes
+#include "QueueOverflowPolicy.h"
 #include "VerifyLocked.h"
 
 // Library/third-party includes
 // - none
 
 // Standard includes
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
 #include <mutex>
 #include <utility>
 #include <vector>
@@ -41,44 +44,61 @@
 namespace osvr {
 namespace vive {
 
-    /// A container wrapping a deque (mutex-controlled) and a vector (for main
-    /// thread use only), where work is submitted to the deque, then the main
-    /// thread, upon entering, grabs a number of items from the deque to the
-    /// vector before beginning work on them, allowing shorter lock times.
+    /// A pair of vectors, one mutex-controlled and one for main thread use
+    /// only, where work is submitted to the first, then the main thread, upon
+    /// entering, grabs all the items by swapping the two before beginning
+    /// work on them. The lock is thus held for constant time no matter how
+    /// much has piled up, and since both vectors keep their capacity as they
+    /// trade places, a steady state does no allocation.
+    ///
+    /// Optionally bounded: given a capacity, both vectors are allocated up
+    /// front and a full queue handles submissions according to its
+    /// QueueOverflowPolicy. (Drop-oldest overwrites in place, then the grab
+    /// following an overflow rotates the items back into order.)
     template <typename T, typename LockType = std::lock_guard<std::mutex>>
     class QuickProcessingDeque {
       public:
         using value_type = T;
-        using deque_type = std::deque<T>;
         using vector_type = std::vector<T>;
         using lock_type = LockType;
 
+        /// @param capacity 0 for unbounded.
+        explicit QuickProcessingDeque(
+            std::size_t capacity = 0,
+            QueueOverflowPolicy policy = QueueOverflowPolicy::NeverDrop)
+            : capacity_(capacity), policy_(policy) {
+            pending_.reserve(capacity_);
+            vector_.reserve(capacity_);
+        }
+
         /// Call from the async thread you can't control
         /// Must hold the lock.
-        void submitNew(value_type const &v, lock_type &lock) {
-            if (verifyLocked<lock_type>(lock)) {
-                deque_.push_back(v);
-            }
+        /// @return false if a report was dropped - this one, or an older one
+        /// to make room for it.
+        bool submitNew(value_type const &v, lock_type &lock) {
+            return submitImpl(v, lock);
         }
 
-        void submitNew(value_type &&v, lock_type &lock) {
-            if (verifyLocked<lock_type>(lock)) {
-                deque_.emplace_back(std::move(v));
-            }
+        /// @overload
+        bool submitNew(value_type &&v, lock_type &lock) {
+            return submitImpl(std::move(v), lock);
         }
 
-        /// Call from the main thread to grab a chunk of work to deal with.
+        /// Call from the main thread to grab all the work submitted so far to
+        /// deal with.
         /// Must hold the lock.
         std::size_t grabItems(lock_type &lock) {
             if (verifyLocked<lock_type>(lock)) {
+                /// Only costs anything if the last batch wasn't already
+                /// cleared (and has elements with destructors).
                 clearWorkItems();
-                /// Copy a fixed number of reports that have been queued up.
-                auto numItems = deque_.size();
-                for (std::size_t i = 0; i < numItems; ++i) {
-                    vector_.push_back(deque_.front());
-                    deque_.pop_front();
+                vector_.swap(pending_);
+                if (oldest_ != 0) {
+                    std::rotate(vector_.begin(), vector_.begin() + oldest_,
+                                vector_.end());
+                    oldest_ = 0;
                 }
-                return numItems;
+                return vector_.size();
             }
             return 0;
         }
@@ -89,12 +109,84 @@ namespace vive {
         vector_type const &accessWorkItems() const { return vector_; }
 
         /// Not necessary, since it's called at the beginning of each grabItems,
-        /// but if you really want to reduce time in lock...
+        /// but calling it after you're done with the items keeps their
+        /// destruction out of the lock.
         void clearWorkItems() { vector_.clear(); }
 
+        /// 0 if unbounded.
+        std::size_t capacity() const { return capacity_; }
+        QueueOverflowPolicy policy() const { return policy_; }
+
+        /// @name Counters
+        /// Safe to call from any thread without the lock.
+        /// @{
+        /// Total reports discarded so far.
+        std::uint64_t getDroppedCount() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+        /// Total submissions so far that found the queue at capacity -
+        /// whether or not the policy then dropped anything.
+        std::uint64_t getOverflowCount() const {
+            return overflows_.load(std::memory_order_relaxed);
+        }
+        /// Most reports ever waiting at once.
+        std::size_t getHighWaterMark() const {
+            return highWater_.load(std::memory_order_relaxed);
+        }
+        /// @}
+
       private:
-        /// for mutex-controlled use.
-        deque_type deque_;
+        template <typename V> bool submitImpl(V &&v, lock_type &lock) {
+            if (!verifyLocked<lock_type>(lock)) {
+                return false;
+            }
+            if (capacity_ != 0 && pending_.size() >= capacity_) {
+                increment(overflows_);
+                switch (policy_) {
+                case QueueOverflowPolicy::DropOldest:
+                    /// Overwrite the oldest in place, rather than shifting
+                    /// everything down.
+                    pending_[oldest_] = std::forward<V>(v);
+                    oldest_ = (oldest_ + 1) % pending_.size();
+                    increment(dropped_);
+                    return false;
+                case QueueOverflowPolicy::DropNewest:
+                    increment(dropped_);
+                    return false;
+                case QueueOverflowPolicy::NeverDrop:
+                    break;
+                }
+            }
+            pending_.emplace_back(std::forward<V>(v));
+            if (pending_.size() > highWater_.load(std::memory_order_relaxed)) {
+                highWater_.store(pending_.size(), std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        /// Only written with the lock held, so no read-modify-write needed.
+        template <typename C> static void increment(std::atomic<C> &counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+        }
+
+        const std::size_t capacity_;
+        const QueueOverflowPolicy policy_;
+
+        /// @name Mutex-controlled
+        /// @{
+        vector_type pending_;
+        /// Index of the oldest item in pending_ - nonzero only once
+        /// drop-oldest has overwritten something.
+        std::size_t oldest_ = 0;
+        /// @}
+
+        /// @name Written under the mutex, readable from anywhere
+        /// @{
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<std::uint64_t> overflows_{0};
+        std::atomic<std::size_t> highWater_{0};
+        /// @}
 
         /// for temporary use by the main thread.
         vector_type vector_;
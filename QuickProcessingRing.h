@@ -0,0 +1,289 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_QuickProcessingRing_h_GUID_3C1F6A52_9E4B_4D0C_B7A1_5F2E8C6D9A10
+#define INCLUDED_QuickProcessingRing_h_GUID_3C1F6A52_9E4B_4D0C_B7A1_5F2E8C6D9A10
+
+// Internal Includes
+#include "QueueOverflowPolicy.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osvr {
+namespace vive {
+    /// Size we assume for a cache line when padding apart the atomics that
+    /// the producer and consumer sides hammer on.
+    static const std::size_t QUICK_PROCESSING_CACHE_LINE = 64;
+
+    /// A bounded, lock-free counterpart to QuickProcessingDeque: work is
+    /// submitted into a fixed ring of slots (no allocation after
+    /// construction), then the main thread grabs everything available into a
+    /// vector before beginning work on it.
+    ///
+    /// Any number of threads may submit (each slot carries its own sequence
+    /// number, so the driver calling back from more than one thread is fine),
+    /// but only the main thread may grab. When the ring is full, an item is
+    /// dropped and counted rather than blocking the submitting thread: with
+    /// QueueOverflowPolicy::DropOldest, the submitter dequeues the oldest
+    /// waiting item itself (claiming it the same way the main thread does, so
+    /// the two can't both take it); otherwise the new item is dropped. The
+    /// ring can't grow, so NeverDrop behaves like DropNewest.
+    ///
+    /// The grab/submit methods also accept (and ignore) a lock, so this can be
+    /// dropped in wherever a QuickProcessingDeque was used.
+    template <typename T> class QuickProcessingRing {
+      public:
+        using value_type = T;
+        using vector_type = std::vector<T>;
+
+        static const std::size_t DEFAULT_CAPACITY = 4096;
+
+        /// @param capacity Minimum number of items the ring can hold - rounded
+        /// up to a power of two. (0 means DEFAULT_CAPACITY, since the ring
+        /// can't be unbounded)
+        /// @param policy What to drop when full - NeverDrop can't be done
+        /// without growing, so it means DropNewest here.
+        explicit QuickProcessingRing(
+            std::size_t capacity = DEFAULT_CAPACITY,
+            QueueOverflowPolicy policy = QueueOverflowPolicy::DropNewest)
+            : mask_(roundUpToPowerOfTwo(capacity ? capacity
+                                                  : DEFAULT_CAPACITY) -
+                    1),
+              cells_(new Cell[mask_ + 1]),
+              dropOldest_(policy == QueueOverflowPolicy::DropOldest) {
+            for (std::size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            vector_.reserve(mask_ + 1);
+        }
+
+        QuickProcessingRing(QuickProcessingRing const &) = delete;
+        QuickProcessingRing &operator=(QuickProcessingRing const &) = delete;
+
+        /// Call from the async thread(s) you can't control. Never blocks.
+        /// @return false if the ring was full and an item (this one, or an
+        /// older one with DropOldest) was dropped.
+        bool submitNew(value_type const &v) {
+            return emplaceImpl([&](value_type &slot) { slot = v; });
+        }
+
+        /// @overload
+        bool submitNew(value_type &&v) {
+            return emplaceImpl([&](value_type &slot) { slot = std::move(v); });
+        }
+
+        /// @overload
+        /// Lock ignored - signature-compatible with QuickProcessingDeque.
+        template <typename LockType>
+        bool submitNew(value_type const &v, LockType & /*lock*/) {
+            return submitNew(v);
+        }
+
+        /// @overload
+        template <typename LockType>
+        bool submitNew(value_type &&v, LockType & /*lock*/) {
+            return submitNew(std::move(v));
+        }
+
+        /// Call from the main thread only, to grab everything submitted so far
+        /// to deal with.
+        std::size_t grabItems() {
+            clearWorkItems();
+            /// Never take more than one trip around the ring, so a steady
+            /// stream of submissions can't keep us in here forever.
+            for (std::size_t i = 0; i <= mask_; ++i) {
+                if (!dequeueImpl([&](value_type &value) {
+                        vector_.push_back(std::move(value));
+                    })) {
+                    /// Empty (or a producer hasn't finished writing yet)
+                    break;
+                }
+            }
+            if (vector_.size() > highWater_.load(std::memory_order_relaxed)) {
+                highWater_.store(vector_.size(), std::memory_order_relaxed);
+            }
+            return vector_.size();
+        }
+
+        /// @overload
+        /// Lock ignored - signature-compatible with QuickProcessingDeque.
+        template <typename LockType>
+        std::size_t grabItems(LockType & /*lock*/) {
+            return grabItems();
+        }
+
+        /// Call from the main thread, after calling grabItems, to get access
+        /// to the items you just grabbed. (Cleared automatically every call to
+        /// grabItems)
+        vector_type const &accessWorkItems() const { return vector_; }
+
+        /// Not necessary, since it's called at the beginning of each grabItems.
+        void clearWorkItems() { vector_.clear(); }
+
+        /// @return the actual number of slots in the ring.
+        std::size_t capacity() const { return mask_ + 1; }
+
+        QueueOverflowPolicy policy() const {
+            return dropOldest_ ? QueueOverflowPolicy::DropOldest
+                               : QueueOverflowPolicy::DropNewest;
+        }
+
+        /// @return the total number of items dropped so far because the ring
+        /// was full when something was submitted. Safe to call from any
+        /// thread.
+        std::uint64_t getOverflowCount() const {
+            return overflowCount_.load(std::memory_order_relaxed);
+        }
+
+        /// Same as getOverflowCount(), since every overflow drops an item
+        /// (the new one or the oldest) - for symmetry with
+        /// QuickProcessingDeque.
+        std::uint64_t getDroppedCount() const { return getOverflowCount(); }
+
+        /// @return the most items ever grabbed at once - a lower bound on
+        /// the most ever waiting. Safe to call from any thread.
+        std::size_t getHighWaterMark() const {
+            return highWater_.load(std::memory_order_relaxed);
+        }
+
+      private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            value_type value;
+        };
+
+        static std::size_t roundUpToPowerOfTwo(std::size_t n) {
+            std::size_t ret = 2;
+            while (ret < n) {
+                ret <<= 1;
+            }
+            return ret;
+        }
+
+        template <typename F> bool emplaceImpl(F &&assign) {
+            auto pos = enqueuePos_.load(std::memory_order_relaxed);
+            Cell *cell;
+            bool droppedOldest = false;
+            for (;;) {
+                cell = &cells_[pos & mask_];
+                auto seq = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq) -
+                            static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    /// Slot is free for this lap - try to claim it.
+                    if (enqueuePos_.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    /// The consumer hasn't gotten to this slot yet: full.
+                    overflowCount_.fetch_add(1, std::memory_order_relaxed);
+                    /// (An evicted item is just overwritten on the next lap.)
+                    if (!dropOldest_ ||
+                        !dequeueImpl([](value_type & /*evicted*/) {})) {
+                        /// Drop-newest - or the oldest is still being
+                        /// written, so there's nothing to evict.
+                        return false;
+                    }
+                    droppedOldest = true;
+                    pos = enqueuePos_.load(std::memory_order_relaxed);
+                } else {
+                    /// Another producer got here first.
+                    pos = enqueuePos_.load(std::memory_order_relaxed);
+                }
+            }
+            std::forward<F>(assign)(cell->value);
+            /// Publish to the consumer.
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return !droppedOldest;
+        }
+
+        /// Claims the oldest published item, hands it to take, then frees
+        /// its slot for the producers' next lap. Called by the main thread,
+        /// and by producers evicting with DropOldest.
+        /// @return false if there was nothing published to claim.
+        template <typename F> bool dequeueImpl(F &&take) {
+            auto pos = dequeuePos_.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;) {
+                cell = &cells_[pos & mask_];
+                auto seq = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq) -
+                            static_cast<std::intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeuePos_.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    /// Empty, or not finished being written.
+                    return false;
+                } else {
+                    /// Someone else took it first.
+                    pos = dequeuePos_.load(std::memory_order_relaxed);
+                }
+            }
+            std::forward<F>(take)(cell->value);
+            cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        const std::size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        const bool dropOldest_;
+
+        /// @name Producer side
+        /// Padded apart from the consumer side to avoid false sharing.
+        /// @{
+        char padBeforeEnqueue_[QUICK_PROCESSING_CACHE_LINE];
+        std::atomic<std::size_t> enqueuePos_{0};
+        std::atomic<std::uint64_t> overflowCount_{0};
+        char padAfterEnqueue_[QUICK_PROCESSING_CACHE_LINE];
+        /// @}
+
+        /// @name Consumer side
+        /// Producers only touch dequeuePos_ when evicting with DropOldest.
+        /// @{
+        std::atomic<std::size_t> dequeuePos_{0};
+        /// Main thread only.
+        vector_type vector_;
+        /// @}
+
+        /// Written by the main thread, readable from anywhere.
+        std::atomic<std::size_t> highWater_{0};
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_QuickProcessingRing_h_GUID_3C1F6A52_9E4B_4D0C_B7A1_5F2E8C6D9A10
@@ -0,0 +1,187 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_RunFramePacer_h_GUID_6A3E0F58_C2B9_4D17_9E46_B8D1A07C5F23
+#define INCLUDED_RunFramePacer_h_GUID_6A3E0F58_C2B9_4D17_9E46_B8D1A07C5F23
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace osvr {
+namespace vive {
+    /// Summary of the intervals between frames started by a RunFramePacer.
+    struct RunFrameStats {
+        std::uint64_t frames = 0;
+        /// Frames that ran past the start of the next one - the schedule is
+        /// then restarted rather than trying to catch up.
+        std::uint64_t overruns = 0;
+        /// @name Intervals between frame starts, in seconds
+        /// @{
+        double meanInterval = 0;
+        double stdDevInterval = 0;
+        double minInterval = 0;
+        double maxInterval = 0;
+        /// @}
+    };
+
+    /// Owns a thread that calls a function (RunFrame, for us) at a fixed
+    /// rate, keeping statistics on how evenly it manages to do so.
+    class RunFramePacer {
+      public:
+        using clock = std::chrono::steady_clock;
+
+        /// Starts the thread right away.
+        RunFramePacer(std::function<void()> frame, double rateHz)
+            : frame_(std::move(frame)),
+              period_(std::chrono::duration_cast<clock::duration>(
+                  std::chrono::duration<double>(1. / rateHz))),
+              thread_([this] { threadFunc(); }) {}
+
+        /// Stops and joins the thread.
+        ~RunFramePacer() { stop(); }
+
+        RunFramePacer(RunFramePacer const &) = delete;
+        RunFramePacer &operator=(RunFramePacer const &) = delete;
+
+        /// Stops the thread (waiting for any frame in progress to finish).
+        /// Safe to call more than once.
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            cv_.notify_all();
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        /// @return statistics accumulated since the last call.
+        RunFrameStats takeStats() {
+            Accumulator acc;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::swap(acc, acc_);
+            }
+            RunFrameStats ret;
+            ret.frames = acc.frames;
+            ret.overruns = acc.overruns;
+            if (acc.intervals > 0) {
+                auto n = static_cast<double>(acc.intervals);
+                ret.meanInterval = acc.sum / n;
+                auto variance =
+                    acc.sumSq / n - ret.meanInterval * ret.meanInterval;
+                ret.stdDevInterval = variance > 0 ? std::sqrt(variance) : 0.;
+                ret.minInterval = acc.min;
+                ret.maxInterval = acc.max;
+            }
+            return ret;
+        }
+
+      private:
+        struct Accumulator {
+            std::uint64_t frames = 0;
+            std::uint64_t overruns = 0;
+            std::uint64_t intervals = 0;
+            double sum = 0;
+            double sumSq = 0;
+            double min = 0;
+            double max = 0;
+        };
+
+        void threadFunc() {
+            auto next = clock::now();
+            auto lastStart = next;
+            bool first = true;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stopping_) {
+                auto start = clock::now();
+                if (!first) {
+                    recordInterval(
+                        std::chrono::duration<double>(start - lastStart)
+                            .count());
+                }
+                first = false;
+                lastStart = start;
+                ++acc_.frames;
+
+                lock.unlock();
+                frame_();
+                lock.lock();
+
+                next += period_;
+                auto now = clock::now();
+                if (next < now) {
+                    ++acc_.overruns;
+                    next = now;
+                }
+                cv_.wait_until(lock, next, [&] { return stopping_; });
+            }
+        }
+
+        /// Must hold the mutex.
+        void recordInterval(double interval) {
+            if (0 == acc_.intervals || interval < acc_.min) {
+                acc_.min = interval;
+            }
+            if (0 == acc_.intervals || interval > acc_.max) {
+                acc_.max = interval;
+            }
+            ++acc_.intervals;
+            acc_.sum += interval;
+            acc_.sumSq += interval * interval;
+        }
+
+        std::function<void()> frame_;
+        const clock::duration period_;
+
+        /// @name Mutex-controlled
+        /// @{
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stopping_ = false;
+        Accumulator acc_;
+        /// @}
+
+        /// Last, so everything else is set up before it starts.
+        std::thread thread_;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_RunFramePacer_h_GUID_6A3E0F58_C2B9_4D17_9E46_B8D1A07C5F23
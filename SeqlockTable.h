@@ -0,0 +1,181 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_SeqlockTable_h_GUID_7C2E5A94_1F3B_4D86_A8E0_5B9D2C47F163
+#define INCLUDED_SeqlockTable_h_GUID_7C2E5A94_1F3B_4D86_A8E0_5B9D2C47F163
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace osvr {
+namespace vive {
+    /// A fixed-size table of the latest value per index, written and read
+    /// from any threads without locks, using a sequence lock per entry.
+    ///
+    /// Writers never wait: a writer claims the entry by moving its sequence
+    /// number from even to odd with a single compare-and-swap, and if another
+    /// writer holds it (or beat it to the swap), the write is dropped - it
+    /// was racing a value just as new. Each entry holds two copies, and a
+    /// writer fills the one not holding the latest value before publishing
+    /// it, so a writer stalled mid-write (say, preempted) doesn't keep
+    /// readers from the previous value. Readers never block writers either:
+    /// they copy the latest and retry only if the sequence number shows a
+    /// writer lapped them, giving up after a few attempts.
+    ///
+    /// The value is stored as relaxed atomic words (and the ordering done
+    /// with fences), so a read racing a write is well-defined - it just gets
+    /// thrown away.
+    template <typename T> class SeqlockTable {
+      public:
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Values are copied word by word.");
+        using value_type = T;
+
+        /// Attempts a reader makes at a consistent copy before giving up.
+        static const int MAX_READ_ATTEMPTS = 16;
+
+        explicit SeqlockTable(std::size_t size)
+            : size_(size), entries_(new Entry[size]) {}
+
+        std::size_t size() const { return size_; }
+
+        /// @return false if the index is out of range, or another write to
+        /// the same entry was in progress (so this one was dropped).
+        bool write(std::size_t i, value_type const &value) {
+            if (!(i < size_)) {
+                return false;
+            }
+            auto &entry = entries_[i];
+            auto seq = entry.seq.load(std::memory_order_relaxed);
+            if ((seq & 1) ||
+                !entry.seq.compare_exchange_strong(seq, seq + 1,
+                                                   std::memory_order_relaxed)) {
+                contendedWrites_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            /// Keeps the stores below from being seen before the entry is
+            /// marked as being written.
+            std::atomic_thread_fence(std::memory_order_release);
+            Words words;
+            std::memcpy(words.data(), &value, sizeof(value_type));
+            auto &copy = entry.copies[latestCopy(seq + 2)];
+            for (std::size_t w = 0; w < WORDS; ++w) {
+                copy[w].store(words[w], std::memory_order_relaxed);
+            }
+            /// Publishes the copy just written as the latest.
+            entry.seq.store(seq + 2, std::memory_order_release);
+            return true;
+        }
+
+        /// @return false if the index is out of range, the entry was never
+        /// written, or no consistent copy could be had (leaving value
+        /// untouched in all cases).
+        bool read(std::size_t i, value_type &value) const {
+            if (!(i < size_)) {
+                return false;
+            }
+            auto const &entry = entries_[i];
+            for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+                auto before = entry.seq.load(std::memory_order_acquire);
+                if (before < 2) {
+                    /// Nothing published yet.
+                    return false;
+                }
+                auto const &copy = entry.copies[latestCopy(before)];
+                Words words;
+                for (std::size_t w = 0; w < WORDS; ++w) {
+                    words[w] = copy[w].load(std::memory_order_relaxed);
+                }
+                /// Keeps the loads above from being satisfied after the
+                /// sequence number is checked again.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                /// The copy we read is only overwritten by the write after
+                /// next: fine as long as that hasn't started.
+                auto after = entry.seq.load(std::memory_order_relaxed);
+                if (after - (before & ~1u) <= 2) {
+                    std::memcpy(&value, words.data(), sizeof(value_type));
+                    return true;
+                }
+            }
+            failedReads_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /// @name Counters
+        /// @{
+        /// Writes dropped because another write to the entry was underway.
+        std::uint64_t getContendedWriteCount() const {
+            return contendedWrites_.load(std::memory_order_relaxed);
+        }
+        /// Reads that gave up after MAX_READ_ATTEMPTS.
+        std::uint64_t getFailedReadCount() const {
+            return failedReads_.load(std::memory_order_relaxed);
+        }
+        /// @}
+
+      private:
+        static const std::size_t WORDS =
+            (sizeof(value_type) + sizeof(std::uint64_t) - 1) /
+            sizeof(std::uint64_t);
+        using Words = std::array<std::uint64_t, WORDS>;
+        using Copy = std::array<std::atomic<std::uint64_t>, WORDS>;
+
+        /// Which copy is the latest complete one, for any sequence number:
+        /// it flips with each finished write.
+        static std::size_t latestCopy(std::uint32_t seq) {
+            return (seq >> 1) & 1;
+        }
+
+        /// Padded out to a multiple of a cache line, so neighboring entries
+        /// written from different threads share at most one line.
+        struct Entry {
+            /// Even when idle, odd while being written; 0 until first
+            /// written.
+            std::atomic<std::uint32_t> seq{0};
+            std::array<Copy, 2> copies;
+            char padding[64 - (sizeof(std::uint64_t) * (2 * WORDS + 1)) % 64];
+        };
+
+        const std::size_t size_;
+        std::unique_ptr<Entry[]> entries_;
+        std::atomic<std::uint64_t> contendedWrites_{0};
+        mutable std::atomic<std::uint64_t> failedReads_{0};
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_SeqlockTable_h_GUID_7C2E5A94_1F3B_4D86_A8E0_5B9D2C47F163
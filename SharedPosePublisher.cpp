@@ -0,0 +1,165 @@
+/** @file
+    @brief Implementation
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "SharedPosePublisher.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace osvr {
+namespace vive {
+    /// The magic number and sequence numbers are plain uint32_t in the C
+    /// layout readers use, so the publisher accesses them through this.
+    static inline std::atomic<std::uint32_t> &asAtomic(std::uint32_t &word) {
+        static_assert(sizeof(std::atomic<std::uint32_t>) ==
+                          sizeof(std::uint32_t),
+                      "Shared words must be usable in place as atomics.");
+        return reinterpret_cast<std::atomic<std::uint32_t> &>(word);
+    }
+
+    SharedPosePublisher::~SharedPosePublisher() {
+#ifndef _WIN32
+        if (shm_) {
+            munmap(shm_, sizeof(OSVRVive_SharedPoses));
+            shm_unlink(name_.c_str());
+        }
+#endif
+    }
+
+    bool SharedPosePublisher::open(std::string const &name) {
+#ifdef _WIN32
+        error_ = "shared memory pose publication is only supported with "
+                 "POSIX shared memory";
+        return false;
+#else
+        auto fail = [&](const char *what) {
+            error_ = std::string(what) + " failed: " + std::strerror(errno);
+            return false;
+        };
+        auto fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) {
+            return fail("shm_open");
+        }
+        if (ftruncate(fd, sizeof(OSVRVive_SharedPoses)) != 0) {
+            auto ret = fail("ftruncate");
+            close(fd);
+            return ret;
+        }
+        auto mem = mmap(nullptr, sizeof(OSVRVive_SharedPoses),
+                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            return fail("mmap");
+        }
+        shm_ = static_cast<OSVRVive_SharedPoses *>(mem);
+        name_ = name;
+
+        /// Readers check the magic number first, so it goes in last: any
+        /// leftovers from a previous run get cleared out before it's valid.
+        asAtomic(shm_->magic).store(0u, std::memory_order_relaxed);
+        std::memset(shm_, 0, sizeof(OSVRVive_SharedPoses));
+        shm_->version = OSVRVIVE_SHARED_POSES_VERSION;
+        shm_->sensorCount = OSVRVIVE_SHARED_POSES_MAX_SENSORS;
+        shm_->poseSize = sizeof(OSVRVive_SharedPose);
+        asAtomic(shm_->magic)
+            .store(OSVRVIVE_SHARED_POSES_MAGIC, std::memory_order_release);
+        return true;
+#endif
+    }
+
+    OSVRVive_SharedPose *SharedPosePublisher::beginWrite(std::uint32_t sensor) {
+        if (!shm_ || !(sensor < shm_->sensorCount)) {
+            return nullptr;
+        }
+        auto &pose = shm_->poses[sensor];
+        /// Only this thread writes, so no read-modify-write needed.
+        auto &seq = asAtomic(pose.seq);
+        seq.store(seq.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+        /// Keeps the stores that follow from being seen before the sequence
+        /// number goes odd.
+        std::atomic_thread_fence(std::memory_order_release);
+        return &pose;
+    }
+
+    void SharedPosePublisher::endWrite(OSVRVive_SharedPose &pose) {
+        auto &seq = asAtomic(pose.seq);
+        seq.store(seq.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_release);
+    }
+
+    void SharedPosePublisher::publish(std::uint32_t sensor,
+                                      OSVR_Pose3 const &pose,
+                                      OSVR_TimeValue const &timestamp,
+                                      std::int32_t trackingResult,
+                                      const double *linearVelocity,
+                                      const double *angularVelocity) {
+        auto out = beginWrite(sensor);
+        if (!out) {
+            return;
+        }
+        out->trackingResult = trackingResult;
+        out->timestampSeconds = timestamp.seconds;
+        out->timestampMicroseconds = timestamp.microseconds;
+        out->poseIsValid = 1;
+        std::copy_n(pose.translation.data, 3, out->translation);
+        std::copy_n(pose.rotation.data, 4, out->rotation);
+        out->velocityIsValid = linearVelocity && angularVelocity;
+        if (out->velocityIsValid) {
+            std::copy_n(linearVelocity, 3, out->linearVelocity);
+            std::copy_n(angularVelocity, 3, out->angularVelocity);
+        }
+        endWrite(*out);
+    }
+
+    void SharedPosePublisher::publishInvalid(std::uint32_t sensor,
+                                             OSVR_TimeValue const &timestamp,
+                                             std::int32_t trackingResult) {
+        auto out = beginWrite(sensor);
+        if (!out) {
+            return;
+        }
+        out->trackingResult = trackingResult;
+        out->timestampSeconds = timestamp.seconds;
+        out->timestampMicroseconds = timestamp.microseconds;
+        out->poseIsValid = 0;
+        endWrite(*out);
+    }
+
+} // namespace vive
+} // namespace osvr
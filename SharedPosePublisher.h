@@ -0,0 +1,91 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_SharedPosePublisher_h_GUID_E1B7C93A_64D2_4F08_B5A3_2C8D0F9E6417
+#define INCLUDED_SharedPosePublisher_h_GUID_E1B7C93A_64D2_4F08_B5A3_2C8D0F9E6417
+
+// Internal Includes
+#include "ViveSharedPoses.h"
+
+// Library/third-party includes
+#include <osvr/Util/ClientReportTypesC.h>
+#include <osvr/Util/TimeValue.h>
+
+// Standard includes
+#include <cstdint>
+#include <string>
+
+namespace osvr {
+namespace vive {
+    /// Owns the POSIX shared memory segment laid out in ViveSharedPoses.h,
+    /// and writes poses into it - from one thread only, so each sensor's
+    /// sequence lock needs no compare-and-swap.
+    ///
+    /// Not available on Windows, where open() always fails.
+    class SharedPosePublisher {
+      public:
+        SharedPosePublisher() = default;
+        /// Unmaps and unlinks the segment: readers that already have it
+        /// mapped keep their (now static) copy.
+        ~SharedPosePublisher();
+        SharedPosePublisher(SharedPosePublisher const &) = delete;
+        SharedPosePublisher &operator=(SharedPosePublisher const &) = delete;
+
+        /// Creates (or takes over) the named segment, like
+        /// "/osvr_vive_poses".
+        /// @return false with errorMessage() set if that failed.
+        bool open(std::string const &name);
+
+        explicit operator bool() const { return shm_ != nullptr; }
+        std::string const &errorMessage() const { return error_; }
+
+        /// Publishes a pose as sent to OSVR.
+        /// @param linearVelocity, angularVelocity room space, or both null
+        /// if unknown.
+        void publish(std::uint32_t sensor, OSVR_Pose3 const &pose,
+                     OSVR_TimeValue const &timestamp,
+                     std::int32_t trackingResult,
+                     const double *linearVelocity = nullptr,
+                     const double *angularVelocity = nullptr);
+
+        /// Publishes that the sensor's latest pose wasn't valid.
+        void publishInvalid(std::uint32_t sensor,
+                            OSVR_TimeValue const &timestamp,
+                            std::int32_t trackingResult);
+
+      private:
+        /// Marks the sensor's entry as being written: returns null if out of
+        /// range.
+        OSVRVive_SharedPose *beginWrite(std::uint32_t sensor);
+        static void endWrite(OSVRVive_SharedPose &pose);
+
+        OSVRVive_SharedPoses *shm_ = nullptr;
+        std::string name_;
+        std::string error_;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_SharedPosePublisher_h_GUID_E1B7C93A_64D2_4F08_B5A3_2C8D0F9E6417
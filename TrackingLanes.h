@@ -0,0 +1,260 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_TrackingLanes_h_GUID_5B8E2D71_C4A9_4F36_9E07_A13D6F2B8C54
+#define INCLUDED_TrackingLanes_h_GUID_5B8E2D71_C4A9_4F36_9E07_A13D6F2B8C54
+
+// Internal Includes
+#include "LatestReportTable.h"
+#include "QueueOverflowPolicy.h"
+#include "QuickProcessingDeque.h"
+#include "QuickProcessingRing.h"
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+namespace osvr {
+namespace vive {
+    /// Submit a report to a mutex-controlled queue: takes the lock.
+    /// @return false if the report was dropped.
+    template <typename T, typename LockType, typename V>
+    inline bool submitToQueue(QuickProcessingDeque<T, LockType> &queue,
+                              std::mutex &mut, V &&report) {
+        LockType lock(mut);
+        return queue.submitNew(std::forward<V>(report), lock);
+    }
+
+    /// Submit a report to a lock-free queue: never touches the mutex.
+    template <typename T, typename V>
+    inline bool submitToQueue(QuickProcessingRing<T> &queue,
+                              std::mutex & /*mut*/, V &&report) {
+        return queue.submitNew(std::forward<V>(report));
+    }
+
+    /// Submit a report to a queue whose lock is already held.
+    /// @return false if the report was dropped.
+    template <typename T, typename LockType>
+    inline bool submitToLockedQueue(QuickProcessingDeque<T, LockType> &queue,
+                                    T const &report, LockType &lock) {
+        return queue.submitNew(report, lock);
+    }
+
+    /// @overload
+    template <typename T, typename LockType>
+    inline bool submitToLockedQueue(QuickProcessingRing<T> &queue,
+                                    T const &report, LockType &lock) {
+        return queue.submitNew(report, lock);
+    }
+
+    /// The path a group of tracking reports takes from the driver callbacks
+    /// to update(): a queue, plus (in coalescing mode) a table holding just
+    /// the newest pose per sensor.
+    ///
+    /// Report needs a sensor member, and a kind member compared against
+    /// Report::Kind::UniverseChange.
+    template <typename Report, typename Queue> class TrackingLane {
+      public:
+        using lock_type = std::lock_guard<std::mutex>;
+
+        explicit TrackingLane(QueueConfig const &config)
+            : reports(config.capacity, config.overflow) {}
+
+        /// Call from the main thread, holding the lock, to grab everything
+        /// submitted so far.
+        void grabItems(lock_type &lock) {
+            reports.grabItems(lock);
+            latest.grabItems(lock);
+            next_ = 0;
+            atUniverseChange_ = false;
+        }
+
+        /// Call from the main thread after grabItems, with the lock
+        /// released: hands each grabbed report to handle, in the order they
+        /// happened.
+        template <typename F> void drain(F &&handle) {
+            while (drainUntilUniverseChange(handle)) {
+            }
+        }
+
+        /// Like drain(), but stops short of the next universe change - which
+        /// the following call hands over first - so the other lane can be
+        /// drained up to its copy of it before it takes effect.
+        /// @return true if it stopped at a universe change, false if
+        /// everything grabbed has been handed over.
+        template <typename F> bool drainUntilUniverseChange(F &&handle) {
+            auto const &items = reports.accessWorkItems();
+            auto n = items.size();
+            if (atUniverseChange_) {
+                atUniverseChange_ = false;
+                handle(items[next_]);
+                ++next_;
+            }
+            for (; next_ < n; ++next_) {
+                if (Report::Kind::UniverseChange == items[next_].kind) {
+                    atUniverseChange_ = true;
+                    return true;
+                }
+                handle(items[next_]);
+            }
+            // then clear this temporary buffer for next time. (done
+            // automatically, but doing it manually here since there will
+            // usually be lots of tracking reports.
+            reports.clearWorkItems();
+            next_ = 0;
+
+            // In coalescing mode, the newest pose per sensor is waiting here -
+            // anything in the queue above was older.
+            for (auto &report : latest.accessWorkItems()) {
+                handle(report);
+            }
+            latest.clearWorkItems();
+            return false;
+        }
+
+        /// Submits reports that must stay in order with everything already
+        /// submitted to the lane - so in coalescing mode, the poses waiting
+        /// in the table are moved into the queue ahead of them.
+        /// @return false if any report was dropped.
+        bool submitOrdered(std::mutex &mut, Report const *items, std::size_t n,
+                           bool coalesce) {
+            bool ret = true;
+            if (coalesce) {
+                lock_type lock(mut);
+                ret = submitOrderedLocked(lock, items, n, true);
+            } else {
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (!submitToQueue(reports, mut, items[i])) {
+                        ret = false;
+                    }
+                }
+            }
+            return ret;
+        }
+
+        /// submitOrdered(), with the lock already held.
+        bool submitOrderedLocked(lock_type &lock, Report const *items,
+                                 std::size_t n, bool coalesce) {
+            bool ret = true;
+            if (coalesce) {
+                latest.drainInto(lock, [&](Report &&pending) {
+                    if (!submitToLockedQueue(reports, pending, lock)) {
+                        ret = false;
+                    }
+                });
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!submitToLockedQueue(reports, items[i], lock)) {
+                    ret = false;
+                }
+            }
+            return ret;
+        }
+
+        Queue reports;
+        /// Used instead of reports for poses in coalescing mode - reports
+        /// then just gets offsets and universe changes (and the poses
+        /// flushed ahead of them).
+        LatestReportTable<Report, lock_type> latest;
+
+      private:
+        /// @name Main thread only: where drainUntilUniverseChange() stopped.
+        /// @{
+        std::size_t next_ = 0;
+        bool atUniverseChange_ = false;
+        /// @}
+    };
+
+    /// Tracking reports split into two lanes, so the HMD's never wait behind
+    /// the rest: update() grabs and drains the HMD lane first, sending its
+    /// poses before grabbing the other lane.
+    ///
+    /// A universe change goes into both lanes, and each lane is drained up to
+    /// it before either copy is handed over - so no pose is converted with a
+    /// universe from after it was reported.
+    template <typename Report, typename Queue> class TrackingLanes {
+      public:
+        using lane_type = TrackingLane<Report, Queue>;
+
+        /// Reports from the HMD, which has a lane to itself.
+        static const std::size_t HMD_LANE_SENSOR = 0;
+
+        /// Both lanes get the same queue configuration.
+        explicit TrackingLanes(QueueConfig const &config)
+            : hmd_(config), others_(config) {}
+
+        /// The HMD's reports: drained and sent first.
+        lane_type &hmd() { return hmd_; }
+        /// Reports from all other sensors.
+        lane_type &others() { return others_; }
+
+        /// The lane for a sensor's reports.
+        lane_type &laneFor(std::size_t sensor) {
+            return HMD_LANE_SENSOR == sensor ? hmd_ : others_;
+        }
+
+        /// Submits a universe change to both lanes under one lock, so a grab
+        /// of either lane sees it in both or neither. Each copy is ordered
+        /// after everything already submitted to its lane, as with
+        /// TrackingLane::submitOrdered().
+        /// @return false if any report was dropped.
+        bool submitUniverseChange(std::mutex &mut, Report const &change,
+                                  bool coalesce) {
+            typename lane_type::lock_type lock(mut);
+            auto ret = hmd_.submitOrderedLocked(lock, &change, 1, coalesce);
+            return others_.submitOrderedLocked(lock, &change, 1, coalesce) &&
+                   ret;
+        }
+
+        /// Call from the main thread, after grabbing the other lane (and,
+        /// if drainUntilUniverseChange() had finished it, the HMD lane again
+        /// under the same lock): hands over the rest of both lanes, each up
+        /// to a universe change before the other's copy of it.
+        /// @param hmdAtUniverseChange what the HMD lane's last
+        /// drainUntilUniverseChange() returned, if it hasn't been re-grabbed.
+        template <typename F>
+        void drainInOrder(bool hmdAtUniverseChange, F &&handle) {
+            if (!hmdAtUniverseChange) {
+                hmdAtUniverseChange = hmd_.drainUntilUniverseChange(handle);
+            }
+            while (hmdAtUniverseChange) {
+                others_.drainUntilUniverseChange(handle);
+                hmdAtUniverseChange = hmd_.drainUntilUniverseChange(handle);
+            }
+            others_.drain(handle);
+        }
+
+      private:
+        lane_type hmd_;
+        lane_type others_;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_TrackingLanes_h_GUID_5B8E2D71_C4A9_4F36_9E07_A13D6F2B8C54
@@ -0,0 +1,121 @@
+/** @file
+    @brief Header
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_TrackingReport_h_GUID_533960C0_4116_4D47_A88F_2094B8AB05B3
+#define INCLUDED_TrackingReport_h_GUID_533960C0_4116_4D47_A88F_2094B8AB05B3
+
+// Internal Includes
+#include <osvr/Util/ClientReportTypesC.h>
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <cstdint>
+
+namespace osvr {
+namespace vive {
+    /// Everything that goes through the tracking queue, packed into a single
+    /// cache line rather than carrying a whole vr::DriverPose_t. The
+    /// rarely-changing offsets that place a pose are only queued (as their own
+    /// records, ahead of the pose) when they change.
+    struct TrackingReport {
+        enum class Kind : std::uint8_t {
+            Pose,
+            /// offset holds qWorldFromDriverRotation and
+            /// vecWorldFromDriverTranslation, for this sensor's poses from here
+            /// on.
+            WorldFromDriver,
+            /// offset holds qDriverFromHeadRotation and
+            /// vecDriverFromHeadTranslation, for this sensor's poses from here
+            /// on.
+            DriverFromHead,
+            /// Optional: motion holds the velocities for the preceding pose of
+            /// this sensor. Queued if reported or needed for prediction.
+            Velocity,
+            /// Optional: motion holds the accelerations for the preceding pose
+            /// of this sensor.
+            Acceleration,
+            UniverseChange
+        };
+
+        struct PosePayload {
+            /// fastClockNs(), already corrected by the pose's poseTimeOffset
+            /// (and filtered, if filterPoseTimestamps is set).
+            std::int64_t timestampNs;
+            double position[3];
+            /// w, x, y, z, narrowed from the driver's doubles. As doubles,
+            /// the timestamp, position and rotation alone would fill the
+            /// cache line. Rounding to float turns the rotation by at most
+            /// about 1e-7 radians (a tenth of a micrometer at a meter), far
+            /// under the tracking noise. The latest-pose table behind
+            /// GetRawTrackedDevicePoses keeps the driver's doubles.
+            float rotation[4];
+            /// Estimated time from sample to callback, in microseconds - 0
+            /// unless filterPoseTimestamps is set and the estimate has
+            /// settled.
+            std::int32_t latencyUs;
+        };
+
+        struct OffsetPayload {
+            /// w, x, y, z
+            double rotation[4];
+            double translation[3];
+        };
+
+        /// Both in driver space - angular in axis-angle form.
+        struct MotionPayload {
+            double linear[3];
+            double angular[3];
+        };
+
+        Kind kind = Kind::Pose;
+        /// @name Pose only
+        /// @{
+        bool poseIsValid = false;
+        /// A vr::ETrackingResult - all of which fit.
+        std::int16_t result = 0;
+        /// @}
+        OSVR_ChannelCount sensor = 0;
+        union {
+            PosePayload pose;
+            OffsetPayload offset;
+            MotionPayload motion;
+            /// For Kind::UniverseChange
+            std::uint64_t newUniverse;
+        };
+#ifdef OSVRVIVE_LATENCY_INSTRUMENTATION
+        /// Pose only: latencyClockNs() when it was queued.
+        std::int64_t queuedNs = 0;
+#endif
+    };
+#ifndef OSVRVIVE_LATENCY_INSTRUMENTATION
+    static_assert(sizeof(TrackingReport) <= 64,
+                  "TrackingReport is meant to fit in a cache line");
+#endif
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_TrackingReport_h_GUID_533960C0_4116_4D47_A88F_2094B8AB05B3
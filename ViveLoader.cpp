@@ -125,13 +125,12 @@ void lookForUniverseData(osvr::vive::DriverWrapper &vive) {
         idx++;
     }
 
-    if (vive.chaperone().knowUniverseId(universe)) {
+    if (auto data = vive.chaperone().findUniverse(universe)) {
         std::cout << PREFIX << "ChaperoneData has info on universe " << universe
                   << std::endl;
-        auto data = vive.chaperone().getDataForUniverse(universe);
-        std::cout << PREFIX << "Translation: [" << data.translation[0] << ", "
-                  << data.translation[1] << ", " << data.translation[2]
-                  << "], yaw " << data.yaw << std::endl;
+        std::cout << PREFIX << "Translation: [" << data->translation[0] << ", "
+                  << data->translation[1] << ", " << data->translation[2]
+                  << "], yaw " << data->yaw << std::endl;
     } else {
         std::cout << PREFIX << "ChaperoneData sadly has no info on universe "
                   << universe << std::endl;
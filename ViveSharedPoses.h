@@ -0,0 +1,164 @@
+/** @file
+    @brief Header - C layout of the shared memory segment ViveDriverHost can
+    publish poses to, with helpers for readers. Standalone: include it in
+    a reader without anything else from this project.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_ViveSharedPoses_h_GUID_3A8F1D62_C5B4_4E97_9F21_D0E6B4A7853C
+#define INCLUDED_ViveSharedPoses_h_GUID_3A8F1D62_C5B4_4E97_9F21_D0E6B4A7853C
+
+/* Internal Includes */
+/* - none */
+
+/* Library/third-party includes */
+/* - none */
+
+/* Standard includes */
+#include <stdint.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSVRVIVE_SHARED_POSES_MAGIC 0x50535653u /* "SVSP" */
+/* Bumped whenever the layout changes. */
+#define OSVRVIVE_SHARED_POSES_VERSION 1u
+#define OSVRVIVE_SHARED_POSES_MAX_SENSORS 64u
+
+/* One sensor's latest pose, exactly as sent to OSVR: room space, same
+   timestamp. 128 bytes: two cache lines. */
+typedef struct OSVRVive_SharedPose {
+    /* Sequence lock: odd while the server is writing, bumped twice per
+       update, 0 if never written. Use osvrViveReadSharedPose() rather than
+       reading the other members directly. */
+    uint32_t seq;
+    /* A vr::ETrackingResult */
+    int32_t trackingResult;
+    /* An OSVR_TimeValue */
+    int64_t timestampSeconds;
+    int32_t timestampMicroseconds;
+    /* If 0, only trackingResult and the timestamp are current. */
+    uint8_t poseIsValid;
+    /* If 0, the velocities are stale: they're only sent if the server's
+       config asks for velocity reporting (or prediction). */
+    uint8_t velocityIsValid;
+    uint8_t reserved[2];
+    double translation[3];
+    /* w, x, y, z */
+    double rotation[4];
+    /* Meters per second */
+    double linearVelocity[3];
+    /* Axis-angle rate, radians per second */
+    double angularVelocity[3];
+} OSVRVive_SharedPose;
+
+typedef struct OSVRVive_SharedPoses {
+    /* Written last by the server: if this isn't
+       OSVRVIVE_SHARED_POSES_MAGIC, the segment isn't ready. */
+    uint32_t magic;
+    uint32_t version;
+    /* The OSVR sensor number is the index into poses. */
+    uint32_t sensorCount;
+    uint32_t poseSize;
+    uint8_t reserved[48];
+    OSVRVive_SharedPose poses[OSVRVIVE_SHARED_POSES_MAX_SENSORS];
+} OSVRVive_SharedPoses;
+
+/* The segment is POSIX shared memory, which the server only publishes off
+   Windows - so the reader helpers, which also use GCC/Clang atomic
+   builtins, are only defined there. */
+#ifndef _WIN32
+/* Gets a consistent copy of a sensor's pose.
+   Returns 1 on success, 0 if never written (or the server kept writing
+   that sensor throughout our attempts). */
+static inline int osvrViveReadSharedPose(OSVRVive_SharedPoses const *shm,
+                                         uint32_t sensor,
+                                         OSVRVive_SharedPose *out) {
+    OSVRVive_SharedPose const *pose;
+    int attempt;
+    if (sensor >= shm->sensorCount) {
+        return 0;
+    }
+    pose = &shm->poses[sensor];
+    for (attempt = 0; attempt < 64; ++attempt) {
+        uint32_t before = __atomic_load_n(&pose->seq, __ATOMIC_ACQUIRE);
+        if (before == 0) {
+            return 0;
+        }
+        if (before & 1u) {
+            continue;
+        }
+        memcpy(out, pose, sizeof(OSVRVive_SharedPose));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&pose->seq, __ATOMIC_RELAXED) == before) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Maps the segment read-only. name is the "sharedPoses" value in the server
+   config, like "/osvr_vive_poses".
+   Returns NULL if it doesn't exist (yet) or isn't a layout we know. */
+static inline OSVRVive_SharedPoses const *
+osvrViveOpenSharedPoses(const char *name) {
+    void *mem;
+    OSVRVive_SharedPoses const *shm;
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    mem = mmap(NULL, sizeof(OSVRVive_SharedPoses), PROT_READ, MAP_SHARED, fd,
+               0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+    shm = (OSVRVive_SharedPoses const *)mem;
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) !=
+            OSVRVIVE_SHARED_POSES_MAGIC ||
+        shm->version != OSVRVIVE_SHARED_POSES_VERSION ||
+        shm->poseSize != sizeof(OSVRVive_SharedPose)) {
+        munmap(mem, sizeof(OSVRVive_SharedPoses));
+        return NULL;
+    }
+    return shm;
+}
+
+static inline void osvrViveCloseSharedPoses(OSVRVive_SharedPoses const *shm) {
+    munmap((void *)shm, sizeof(OSVRVive_SharedPoses));
+}
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* INCLUDED_ViveSharedPoses_h_GUID_3A8F1D62_C5B4_4E97_9F21_D0E6B4A7853C */
@@ -20,6 +20,7 @@
 // limitations under the License.
 
 // Internal Includes
+#include "DriverHostConfig.h"
 #include "DriverWrapper.h"
 #include "InterfaceTraits.h"
 #include "OSVRViveTracker.h"
@@ -31,6 +32,8 @@
 #include "com_osvr_ViveSync_json.h"
 
 // Library/third-party includes
+#include <json/reader.h>
+#include <json/value.h>
 #include <math.h>
 #include <openvr_driver.h>
 
@@ -47,6 +50,9 @@
 namespace {
 
 static const auto PREFIX = "OSVR-Vive";
+static const auto CONFIG_DRIVER_NAME = "ViveConfig";
+
+using DriverHostConfigPtr = std::shared_ptr<osvr::vive::DriverHostConfig>;
 
 class ViveSyncDevice {
   public:
@@ -155,11 +161,38 @@ class ViveSyncDevice {
     osvr::util::log::LoggerPtr m_logger;
 };
 
+/// "Driver" instantiated by a com_osvr_Vive/ViveConfig entry in the server
+/// config: it doesn't create a device itself, it just records the params for
+/// the driver host that hardware detection will create.
+class ConfigureVive {
+  public:
+    explicit ConfigureVive(DriverHostConfigPtr const &config)
+        : m_config(config), m_logger(osvr::util::log::make_logger(PREFIX)) {}
+
+    OSVR_ReturnCode operator()(OSVR_PluginRegContext /*ctx*/,
+                               const char *params) {
+        Json::Value root;
+        Json::Reader reader;
+        if (!reader.parse(params, root)) {
+            m_logger->error("Could not parse ")
+                << CONFIG_DRIVER_NAME
+                << " params: " << reader.getFormattedErrorMessages();
+            return OSVR_RETURN_FAILURE;
+        }
+        osvr::vive::loadDriverHostConfig(root, *m_config);
+        return OSVR_RETURN_SUCCESS;
+    }
+
+  private:
+    DriverHostConfigPtr m_config;
+    osvr::util::log::LoggerPtr m_logger;
+};
+
 class HardwareDetection {
 
   public:
-    HardwareDetection()
-        : m_startedInSuccess(false),
+    explicit HardwareDetection(DriverHostConfigPtr const &config)
+        : m_config(config), m_startedInSuccess(false),
           m_logger(osvr::util::log::make_logger(PREFIX)) {}
 
     OSVR_ReturnCode operator()(OSVR_PluginRegContext ctx) {
@@ -221,12 +254,15 @@ class HardwareDetection {
     /// Creates one if needed.
     osvr::vive::ViveDriverHost &getDriveHost() {
         if (!m_driverHost) {
-            m_driverHost.reset(new osvr::vive::ViveDriverHost);
+            m_driverHost.reset(new osvr::vive::ViveDriverHost(*m_config));
         }
         return *m_driverHost.get();
     }
 
   private:
+    /// Shared with ConfigureVive, which (if configured) gets called before
+    /// the first hardware detection.
+    DriverHostConfigPtr m_config;
     // after first stage startup, we will pass the vive and drivehost
     // to the ViveSyncDevice to complete the second stage startup.
     osvr::vive::DriverWrapperPtr m_viveWrapper;
@@ -240,8 +276,14 @@ class HardwareDetection {
 OSVR_PLUGIN(com_osvr_Vive) {
     osvr::pluginkit::PluginContext context(ctx);
 
+    auto config = std::make_shared<osvr::vive::DriverHostConfig>();
+
+    /// Register the optional configuration "driver".
+    context.registerDriverInstantiationCallback(CONFIG_DRIVER_NAME,
+                                                ConfigureVive(config));
+
     /// Register a detection callback function object.
-    context.registerHardwareDetectCallback(new HardwareDetection());
+    context.registerHardwareDetectCallback(new HardwareDetection(config));
 
     return OSVR_RETURN_SUCCESS;
 }
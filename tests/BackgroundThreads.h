@@ -0,0 +1,98 @@
+/** @file
+    @brief Header - background threads for the benchmarks, standing in for
+    the driver's callbacks or the main thread.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDED_BackgroundThreads_h_GUID_9BC31497_2D59_4AFD_B47A_5D9DFD79A81B
+#define INCLUDED_BackgroundThreads_h_GUID_9BC31497_2D59_4AFD_B47A_5D9DFD79A81B
+
+// Internal Includes
+// - none
+
+// Library/third-party includes
+// - none
+
+// Standard includes
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace osvr {
+namespace vive {
+    /// Threads that each call a function over and over until destroyed -
+    /// like the driver's threads calling back with reports, either paced
+    /// (a sensor reporting at its rate) or flat out (load), or like
+    /// update() grabbing them.
+    class BackgroundThreads {
+      public:
+        using function_type = std::function<void(std::size_t)>;
+
+        /// @param n Number of threads
+        /// @param rateHz Calls per second per thread, or 0 for as fast as
+        /// possible.
+        /// @param produce Called with the thread's index, 0 to n - 1.
+        BackgroundThreads(std::size_t n, double rateHz, function_type produce) {
+            for (std::size_t i = 0; i < n; ++i) {
+                threads_.emplace_back(
+                    [this, i, rateHz, produce] { run(i, rateHz, produce); });
+            }
+        }
+
+        BackgroundThreads(BackgroundThreads const &) = delete;
+        BackgroundThreads &operator=(BackgroundThreads const &) = delete;
+
+        ~BackgroundThreads() {
+            stop_ = true;
+            for (auto &t : threads_) {
+                t.join();
+            }
+        }
+
+      private:
+        void run(std::size_t i, double rateHz, function_type const &produce) {
+            using clock = std::chrono::steady_clock;
+            auto period = rateHz > 0
+                              ? std::chrono::duration_cast<clock::duration>(
+                                    std::chrono::duration<double>(1. / rateHz))
+                              : clock::duration::zero();
+            auto next = clock::now();
+            while (!stop_.load(std::memory_order_relaxed)) {
+                produce(i);
+                if (rateHz > 0) {
+                    next += period;
+                    std::this_thread::sleep_until(next);
+                }
+            }
+        }
+
+        std::atomic<bool> stop_{false};
+        std::vector<std::thread> threads_;
+    };
+
+} // namespace vive
+} // namespace osvr
+
+#endif // INCLUDED_BackgroundThreads_h_GUID_9BC31497_2D59_4AFD_B47A_5D9DFD79A81B
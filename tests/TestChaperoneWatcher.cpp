@@ -0,0 +1,133 @@
+/** @file
+    @brief Test - reloading the chaperone info file when it's rewritten or
+    replaced, and keeping the last good snapshot when it doesn't load.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "ChaperoneWatcher.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace osvr::vive;
+
+namespace {
+    /// A chaperone file listing universes 1 through numUniverses.
+    std::string chaperoneJson(int numUniverses) {
+        std::ostringstream os;
+        os << "{\"jsonid\": \"chaperone_info\", \"universes\": [";
+        for (int i = 1; i <= numUniverses; ++i) {
+            os << (i == 1 ? "" : ", ") << "{\"universeID\": \"" << i
+               << "\", \"standing\": {\"translation\": [0, 0, 0], "
+                  "\"yaw\": 0}, \"trackers\": [{\"serial\": \"LHB-"
+               << i << "\"}]}";
+        }
+        os << "]}";
+        return os.str();
+    }
+
+    void writeFile(std::string const &fn, std::string const &contents) {
+        std::ofstream out(fn.c_str(), std::ios::binary | std::ios::trunc);
+        out << contents;
+    }
+
+    /// The scratch directory with a one-universe chaperone file, loaded, and
+    /// a watcher started on it.
+    struct WatchedDir {
+        WatchedDir()
+            : dir(VIVE_TESTS_SCRATCH_DIR),
+              fn(ChaperoneData::getDataFilePath(dir)) {
+            std::remove((dir + "/chaperone_info.osvrcache").c_str());
+            writeFile(fn, chaperoneJson(1));
+            initial = std::make_shared<ChaperoneData>(dir);
+            watcher.reset(new ChaperoneWatcher(dir, initial));
+        }
+
+        /// Waits for the watcher to count a reload, either way.
+        /// @return false if it didn't within the timeout.
+        bool waitForReload() {
+            /// Generous: polling looks once a second, then waits for the
+            /// file to settle.
+            static const auto TIMEOUT = std::chrono::seconds(10);
+            auto deadline = std::chrono::steady_clock::now() + TIMEOUT;
+            while (std::chrono::steady_clock::now() < deadline) {
+                if (watcher->generation() > 0 ||
+                    watcher->getFailedReloadCount() > 0) {
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+
+        std::string dir;
+        std::string fn;
+        ChaperoneWatcher::SnapshotPtr initial;
+        std::unique_ptr<ChaperoneWatcher> watcher;
+    };
+} // namespace
+
+TEST_CASE("ChaperoneWatcher publishes the file after it changes") {
+    WatchedDir watched;
+    REQUIRE(watched.initial->valid());
+    REQUIRE(watched.watcher->generation() == 0);
+    REQUIRE(watched.watcher->snapshot() == watched.initial);
+
+    SECTION("rewritten in place") {
+        writeFile(watched.fn, chaperoneJson(3));
+    }
+    SECTION("replaced by renaming over it") {
+        auto tempFn = watched.fn + ".tmp";
+        writeFile(tempFn, chaperoneJson(3));
+        REQUIRE(std::rename(tempFn.c_str(), watched.fn.c_str()) == 0);
+    }
+    REQUIRE(watched.waitForReload());
+    REQUIRE(watched.watcher->getFailedReloadCount() == 0);
+    REQUIRE(watched.watcher->generation() == 1);
+    auto snapshot = watched.watcher->snapshot();
+    REQUIRE(snapshot != watched.initial);
+    REQUIRE(snapshot->getNumberOfKnownUniverses() == 3);
+    /// The one it replaced is untouched.
+    REQUIRE(watched.initial->getNumberOfKnownUniverses() == 1);
+}
+
+TEST_CASE("ChaperoneWatcher keeps the last good snapshot when a rewrite is "
+          "malformed") {
+    WatchedDir watched;
+    writeFile(watched.fn, "{\"jsonid\": \"chaperone_info\", \"universes\": [");
+    REQUIRE(watched.waitForReload());
+    REQUIRE(watched.watcher->getFailedReloadCount() == 1);
+    REQUIRE_FALSE(watched.watcher->getLastFailure().empty());
+    REQUIRE(watched.watcher->generation() == 0);
+    REQUIRE(watched.watcher->snapshot() == watched.initial);
+}
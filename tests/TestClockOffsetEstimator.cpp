@@ -0,0 +1,190 @@
+/** @file
+    @brief Test - pose timestamp filtering on synthetic jittery traces.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "ClockOffsetEstimator.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+
+using namespace osvr::vive;
+
+namespace {
+    /// A device sampling at a fixed period on its own clock, delivered after
+    /// a fixed latency plus late-only (exponential) jitter, which the
+    /// driver's sample time estimate shares.
+    class Trace {
+      public:
+        Trace(double periodNs, double latencyNs, double meanJitterNs,
+              unsigned seed)
+            : periodNs_(periodNs), latencyNs_(latencyNs),
+              jitter_(1. / meanJitterNs), engine_(seed) {}
+
+        /// Skip every this-many samples (0 for none), like lost packets.
+        void skipEvery(int n) { skipEvery_ = n; }
+
+        /// Advances to the next delivered sample.
+        void next() {
+            ++n_;
+            if (skipEvery_ && n_ % skipEvery_ == 0) {
+                ++n_;
+            }
+            auto jitter = jitter_(engine_);
+            trueNs_ = START_NS + static_cast<std::int64_t>(periodNs_ * n_);
+            sampleNs_ = trueNs_ + static_cast<std::int64_t>(jitter);
+            receivedNs_ = sampleNs_ + static_cast<std::int64_t>(latencyNs_);
+        }
+
+        std::int64_t trueNs() const { return trueNs_; }
+        std::int64_t sampleNs() const { return sampleNs_; }
+        std::int64_t receivedNs() const { return receivedNs_; }
+
+      private:
+        static const std::int64_t START_NS = 1000000000000LL;
+        double periodNs_;
+        double latencyNs_;
+        std::exponential_distribution<double> jitter_;
+        std::mt19937 engine_;
+        int skipEvery_ = 0;
+        long long n_ = 0;
+        std::int64_t trueNs_ = 0;
+        std::int64_t sampleNs_ = 0;
+        std::int64_t receivedNs_ = 0;
+    };
+
+    struct Errors {
+        double meanAbs = 0.;
+        double maxAbs = 0.;
+        double meanRawAbs = 0.;
+    };
+
+    /// Runs warmup samples, then measures the filtered (and raw) timestamps'
+    /// error from the true sample times over the next count samples.
+    Errors measure(ClockOffsetEstimator &estimator, Trace &trace, int warmup,
+                   int count) {
+        for (int i = 0; i < warmup; ++i) {
+            trace.next();
+            estimator.update(trace.receivedNs(), trace.sampleNs());
+        }
+        Errors ret;
+        for (int i = 0; i < count; ++i) {
+            trace.next();
+            auto filtered =
+                estimator.update(trace.receivedNs(), trace.sampleNs());
+            auto err = std::abs(static_cast<double>(filtered - trace.trueNs()));
+            ret.meanAbs += err;
+            ret.maxAbs = std::max(ret.maxAbs, err);
+            ret.meanRawAbs +=
+                static_cast<double>(trace.sampleNs() - trace.trueNs());
+        }
+        ret.meanAbs /= count;
+        ret.meanRawAbs /= count;
+        return ret;
+    }
+
+    /// 250Hz, with the device clock running 100ppm fast of the host's.
+    static const double PERIOD_NS = 4000000. * 1.0001;
+    static const double LATENCY_NS = 2000000.;
+    static const double MEAN_JITTER_NS = 300000.;
+} // namespace
+
+TEST_CASE("ClockOffsetEstimator passes timestamps through until locked") {
+    ClockOffsetEstimator estimator;
+    Trace trace(PERIOD_NS, LATENCY_NS, MEAN_JITTER_NS, 1);
+    /// Acquiring the line takes a bucket, then it has to fit another.
+    for (std::size_t i = 0; i < ClockOffsetEstimator::BUCKET_SAMPLES; ++i) {
+        trace.next();
+        REQUIRE(estimator.update(trace.receivedNs(), trace.sampleNs()) ==
+                trace.sampleNs());
+    }
+    REQUIRE_FALSE(estimator.locked());
+    REQUIRE(estimator.latencyNs() == 0);
+    for (std::size_t i = 0; i < 2 * ClockOffsetEstimator::BUCKET_SAMPLES;
+         ++i) {
+        trace.next();
+        estimator.update(trace.receivedNs(), trace.sampleNs());
+    }
+    REQUIRE(estimator.locked());
+}
+
+TEST_CASE("ClockOffsetEstimator removes late-only jitter") {
+    auto seed = GENERATE(1u, 2u, 3u);
+    ClockOffsetEstimator estimator;
+    Trace trace(PERIOD_NS, LATENCY_NS, MEAN_JITTER_NS, seed);
+    SECTION("from a steady stream") {}
+    SECTION("from a stream with lost samples") { trace.skipEvery(37); }
+
+    /// Past the first full window of bucket minima.
+    auto errors = measure(
+        estimator, trace,
+        static_cast<int>(ClockOffsetEstimator::BUCKET_SAMPLES *
+                         (ClockOffsetEstimator::NUM_BUCKETS + 2)),
+        5000);
+    REQUIRE(estimator.locked());
+    CAPTURE(errors.meanAbs, errors.maxAbs, errors.meanRawAbs);
+    REQUIRE(errors.meanRawAbs == Approx(MEAN_JITTER_NS).epsilon(0.1));
+    /// Within a few percent of the jitter on average - and never worse
+    /// than a typical raw timestamp.
+    REQUIRE(errors.meanAbs < MEAN_JITTER_NS / 20);
+    REQUIRE(errors.maxAbs < MEAN_JITTER_NS);
+    REQUIRE(estimator.periodNs() == Approx(PERIOD_NS).epsilon(1e-5));
+    /// Receipt is the latency plus the jitter after the true sample time.
+    REQUIRE(static_cast<double>(estimator.latencyNs()) ==
+            Approx(LATENCY_NS + MEAN_JITTER_NS).epsilon(0.05));
+    REQUIRE(static_cast<double>(estimator.jitterNs()) ==
+            Approx(MEAN_JITTER_NS).epsilon(0.3));
+}
+
+TEST_CASE("ClockOffsetEstimator starts over after a stall") {
+    ClockOffsetEstimator estimator;
+    Trace trace(PERIOD_NS, LATENCY_NS, MEAN_JITTER_NS, 4);
+    measure(estimator, trace, 200, 1);
+    REQUIRE(estimator.locked());
+    /// Nothing for longer than the estimator waits.
+    for (int i = 0; i < 100; ++i) {
+        trace.next();
+    }
+    trace.next();
+    REQUIRE(estimator.update(trace.receivedNs(), trace.sampleNs()) ==
+            trace.sampleNs());
+    REQUIRE_FALSE(estimator.locked());
+}
+
+TEST_CASE("ClockOffsetEstimator doesn't lock on to an aperiodic stream") {
+    ClockOffsetEstimator estimator;
+    std::mt19937 engine(5);
+    std::uniform_real_distribution<double> interval(1e6, 9e6);
+    std::int64_t sampleNs = 1000000000000LL;
+    for (int i = 0; i < 2000; ++i) {
+        sampleNs += static_cast<std::int64_t>(interval(engine));
+        REQUIRE(estimator.update(sampleNs + 2000000, sampleNs) == sampleNs);
+    }
+    REQUIRE_FALSE(estimator.locked());
+}
@@ -0,0 +1,189 @@
+/** @file
+    @brief Test - memoized SteamVR/driver lookups, and a benchmark of them.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The path config file lives under LocalAppData on Windows, which a test
+// can't redirect: these only run where it's found through $HOME.
+#ifndef _WIN32
+
+// Internal Includes
+#include "FindDriver.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+
+using namespace osvr::vive;
+
+namespace {
+    const std::string BASE_DIR = VIVE_TESTS_SCRATCH_DIR "/finddriver";
+    const std::string HOME_DIR = BASE_DIR + "/home";
+    const std::string PATH_CONFIG = HOME_DIR + "/.openvr/openvrpaths.vrpath";
+    /// Two SteamVR installs, with names of the same length, so switching
+    /// between them doesn't change the size of the path config file.
+    const std::string ROOT_A = BASE_DIR + "/steamvrA";
+    const std::string ROOT_B = BASE_DIR + "/steamvrB";
+    const std::string CONFIG_DIR = BASE_DIR + "/config";
+
+#ifdef __APPLE__
+    const std::string PLATFORM_DIRNAME = "osx32";
+    const std::string DRIVER_EXTENSION = ".dylib";
+#else
+    const std::string PLATFORM_DIRNAME =
+        sizeof(void *) == 8 ? "linux64" : "linux32";
+    const std::string DRIVER_EXTENSION = ".so";
+#endif
+
+    std::string driverFile(std::string const &root) {
+        return root + "/drivers/lighthouse/bin/" + PLATFORM_DIRNAME +
+               "/driver_lighthouse" + DRIVER_EXTENSION;
+    }
+
+    std::string toolFile(std::string const &root) {
+        return root + "/bin/" + PLATFORM_DIRNAME + "/vrpathreg";
+    }
+
+    /// Creates each directory along the path that doesn't exist yet.
+    void makeDirs(std::string const &dir) {
+        for (auto pos = dir.find('/', 1); pos != std::string::npos;
+             pos = dir.find('/', pos + 1)) {
+            mkdir(dir.substr(0, pos).c_str(), 0755);
+        }
+        mkdir(dir.c_str(), 0755);
+    }
+
+    void touch(std::string const &fn) {
+        makeDirs(fn.substr(0, fn.rfind('/')));
+        std::ofstream(fn.c_str()) << "\n";
+    }
+
+    std::string pathConfigContents(std::string const &root) {
+        return "{\"config\":[\"" + CONFIG_DIR + "\"],\"external_drivers\":" +
+               "null,\"jsonid\":\"vrpathreg\",\"log\":[],\"runtime\":[\"" +
+               root + "\"],\"version\":1}\n";
+    }
+
+    /// Replaces the path config file the way a careful writer does: write a
+    /// new file, then rename it into place.
+    void replacePathConfig(std::string const &root) {
+        auto tmp = PATH_CONFIG + ".tmp";
+        {
+            std::ofstream os(tmp.c_str());
+            os << pathConfigContents(root);
+        }
+        std::rename(tmp.c_str(), PATH_CONFIG.c_str());
+    }
+
+    /// Rewrites the path config file in place.
+    void rewritePathConfig(std::string const &root) {
+        std::ofstream os(PATH_CONFIG.c_str(), std::ios::trunc);
+        os << pathConfigContents(root);
+    }
+
+    /// Sets up both installs, with the path config file pointing at A.
+    ///
+    /// The path config file's location is only worked out once per process,
+    /// so HOME has to be set before anything looks for the driver - no
+    /// other test does.
+    void setUpFixture() {
+        static bool done = false;
+        if (!done) {
+            setenv("HOME", HOME_DIR.c_str(), 1);
+            makeDirs(CONFIG_DIR + "/lighthouse");
+            done = true;
+        }
+        for (auto &root : {ROOT_A, ROOT_B}) {
+            touch(driverFile(root));
+            touch(toolFile(root));
+        }
+        makeDirs(HOME_DIR + "/.openvr");
+        replacePathConfig(ROOT_A);
+    }
+} // namespace
+
+TEST_CASE("FindDriver lookups follow the path config file") {
+    setUpFixture();
+
+    auto info = findLocationInfoForDriver();
+    REQUIRE(info.found);
+    REQUIRE(info.steamVrRoot == ROOT_A);
+    REQUIRE(info.driverFile == driverFile(ROOT_A));
+    REQUIRE(info.rootConfigDir == CONFIG_DIR);
+    REQUIRE(info.driverConfigDir == CONFIG_DIR + "/lighthouse");
+    REQUIRE(findDriver().steamVrRoot == ROOT_A);
+    REQUIRE(getToolLocation() == toolFile(ROOT_A));
+
+    SECTION("Repeat lookups are answered from memory") {
+        std::remove(driverFile(ROOT_A).c_str());
+        REQUIRE(findDriver().found);
+        REQUIRE(findLocationInfoForDriver().steamVrRoot == ROOT_A);
+        std::remove(toolFile(ROOT_A).c_str());
+        REQUIRE(getToolLocation() == toolFile(ROOT_A));
+    }
+
+    SECTION("A new file renamed into place within the second is noticed") {
+        replacePathConfig(ROOT_B);
+        REQUIRE(findDriver().steamVrRoot == ROOT_B);
+        REQUIRE(findLocationInfoForDriver().steamVrRoot == ROOT_B);
+        REQUIRE(getToolLocation() == toolFile(ROOT_B));
+    }
+
+    SECTION("Rewriting the file within the second is noticed") {
+        rewritePathConfig(ROOT_B);
+        REQUIRE(findDriver().steamVrRoot == ROOT_B);
+        REQUIRE(getToolLocation() == toolFile(ROOT_B));
+    }
+
+    SECTION("A rewrite that finds nothing is noticed too") {
+        std::remove(driverFile(ROOT_A).c_str());
+        replacePathConfig(ROOT_A);
+        REQUIRE_FALSE(findDriver().found);
+        REQUIRE_FALSE(findLocationInfoForDriver().found);
+    }
+}
+
+/// Hidden: run with `ViveTests [benchmark]`.
+TEST_CASE("FindDriver lookup benchmark", "[.][benchmark]") {
+    setUpFixture();
+    REQUIRE(findLocationInfoForDriver().found);
+
+    BENCHMARK("Memoized lookup") { return findLocationInfoForDriver(); };
+
+    /// Includes writing the file - compare against "Path config rewrite"
+    /// for what the lookup itself costs.
+    BENCHMARK("Lookup after the path config changes") {
+        replacePathConfig(ROOT_A);
+        return findLocationInfoForDriver();
+    };
+
+    BENCHMARK("Path config rewrite") { replacePathConfig(ROOT_A); };
+}
+
+#endif // !_WIN32
@@ -0,0 +1,117 @@
+/** @file
+    @brief Test - the blocked play area distance query against a plain loop
+    over the segments.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "PlayAreaBounds.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+
+using namespace osvr::vive;
+
+namespace {
+    /// One segment at a time, with the obvious branches.
+    double naiveDistance(PlayAreaBounds const &bounds, double x, double z) {
+        auto best = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < bounds.size(); ++i) {
+            auto x0 = bounds.startX(i);
+            auto z0 = bounds.startZ(i);
+            auto dx = bounds.endX(i) - x0;
+            auto dz = bounds.endZ(i) - z0;
+            auto lenSq = dx * dx + dz * dz;
+            auto t = 0.;
+            if (lenSq > 0.) {
+                t = ((x - x0) * dx + (z - z0) * dz) / lenSq;
+                if (t < 0.) {
+                    t = 0.;
+                } else if (t > 1.) {
+                    t = 1.;
+                }
+            }
+            best = std::min(best,
+                            std::hypot(x - (x0 + t * dx), z - (z0 + t * dz)));
+        }
+        return best;
+    }
+} // namespace
+
+TEST_CASE("Empty play area bounds are infinitely far away") {
+    PlayAreaBounds bounds;
+    REQUIRE(bounds.empty());
+    REQUIRE(std::isinf(bounds.distance(0., 0.)));
+    REQUIRE(std::isinf(bounds.distance(1e6, -1e6)));
+}
+
+TEST_CASE("Play area distance past a segment's ends is to the end point") {
+    PlayAreaBounds bounds;
+    bounds.addSegment(0., 0., 2., 0.);
+    REQUIRE(bounds.distance(1., 3.) == Approx(3.));
+    REQUIRE(bounds.distance(-3., 4.) == Approx(5.));
+    REQUIRE(bounds.distance(5., -4.) == Approx(5.));
+
+    SECTION("and a zero-length segment is just a point") {
+        bounds.addSegment(10., 10., 10., 10.);
+        REQUIRE(bounds.distance(13., 14.) == Approx(5.));
+        REQUIRE(bounds.distance(10., 10.) == 0.);
+    }
+}
+
+TEST_CASE("Play area distance agrees with a per-segment loop") {
+    /// Segment counts either side of multiples of LANES.
+    auto numSegments =
+        GENERATE(range<std::size_t>(1, 3 * PlayAreaBounds::LANES + 2));
+    CAPTURE(numSegments);
+    std::mt19937 engine(static_cast<unsigned>(24 + numSegments));
+    std::uniform_real_distribution<double> wall(-3., 3.);
+    /// Points well outside the walls too, so past their ends.
+    std::uniform_real_distribution<double> point(-10., 10.);
+    PlayAreaBounds bounds;
+    for (std::size_t i = 0; i < numSegments; ++i) {
+        auto x0 = wall(engine);
+        auto z0 = wall(engine);
+        if (i % 3 == 1) {
+            /// Zero length.
+            bounds.addSegment(x0, z0, x0, z0);
+        } else {
+            bounds.addSegment(x0, z0, wall(engine), wall(engine));
+        }
+    }
+    REQUIRE(bounds.size() == numSegments);
+    for (int i = 0; i < 1000; ++i) {
+        auto x = point(engine);
+        auto z = point(engine);
+        CAPTURE(x);
+        CAPTURE(z);
+        REQUIRE(bounds.distance(x, z) ==
+                Approx(naiveDistance(bounds, x, z)).margin(1e-12));
+    }
+}
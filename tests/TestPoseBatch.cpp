@@ -0,0 +1,327 @@
+/** @file
+    @brief Test - the batched pose conversion against the scalar one, and a
+    benchmark of the cached transform chain.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "PoseBatch.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <random>
+#include <vector>
+
+using namespace osvr::vive;
+
+namespace {
+    /// Random poses, offsets and universe transforms - seeded, so failures
+    /// reproduce.
+    class PoseGenerator {
+      public:
+        explicit PoseGenerator(unsigned seed) : engine_(seed) {}
+
+        double position() {
+            return std::uniform_real_distribution<double>(-5., 5.)(engine_);
+        }
+
+        Eigen::Quaterniond rotation() {
+            std::normal_distribution<double> normal;
+            Eigen::Quaterniond q(normal(engine_), normal(engine_),
+                                 normal(engine_), normal(engine_));
+            q.normalize();
+            return q;
+        }
+
+        vr::HmdQuaternion_t hmdRotation() {
+            auto q = rotation();
+            vr::HmdQuaternion_t ret;
+            ret.w = q.w();
+            ret.x = q.x();
+            ret.y = q.y();
+            ret.z = q.z();
+            return ret;
+        }
+
+        PoseOffsets offsets() {
+            PoseOffsets ret;
+            ret.qWorldFromDriverRotation = hmdRotation();
+            ret.qDriverFromHeadRotation = hmdRotation();
+            for (int i = 0; i < 3; ++i) {
+                ret.vecWorldFromDriverTranslation[i] = position();
+                /// Head offsets are small in practice.
+                ret.vecDriverFromHeadTranslation[i] = position() / 50.;
+            }
+            return ret;
+        }
+
+        /// Like a chaperone universe: a translation and a yaw.
+        double yaw() {
+            return std::uniform_real_distribution<double>(-3.14, 3.14)(
+                engine_);
+        }
+
+      private:
+        std::mt19937 engine_;
+    };
+
+    /// The conversion one pose at a time, straight from the offsets, as
+    /// the chain of transforms it is.
+    OSVR_Pose3 convertScalar(Eigen::Isometry3d const &universeXform,
+                             Eigen::Quaterniond const &universeRotation,
+                             PoseOffsets const &offsets,
+                             const double position[3],
+                             const float rotation[4]) {
+        using namespace Eigen;
+        Isometry3d worldFromDriver =
+            Translation3d(
+                Vector3d::Map(offsets.vecWorldFromDriverTranslation)) *
+            quatFromSteamVR(offsets.qWorldFromDriverRotation);
+        Translation3d driverFromHeadTranslation(
+            Vector3d::Map(offsets.vecDriverFromHeadTranslation));
+        Quaterniond q(rotation[0], rotation[1], rotation[2], rotation[3]);
+        OSVR_Pose3 ret;
+        Vector3d::Map(ret.translation.data) =
+            (universeXform * worldFromDriver *
+             Translation3d(Vector3d::Map(position)) * q *
+             driverFromHeadTranslation)
+                .translation();
+        Quaterniond r = universeRotation *
+                        quatFromSteamVR(offsets.qWorldFromDriverRotation) * q *
+                        quatFromSteamVR(offsets.qDriverFromHeadRotation);
+        ret.rotation.data[0] = r.w();
+        ret.rotation.data[1] = r.x();
+        ret.rotation.data[2] = r.y();
+        ret.rotation.data[3] = r.z();
+        return ret;
+    }
+
+    struct Input {
+        OSVR_ChannelCount sensor;
+        OSVR_TimeValue timestamp;
+        double position[3];
+        float rotation[4];
+    };
+} // namespace
+
+TEST_CASE("PoseBatch matches the scalar conversion on random poses") {
+    /// Sizes on either side of the batch's initial room, and after it's
+    /// grown a few times.
+    auto n = GENERATE(1, 15, 16, 17, 100);
+    PoseGenerator gen(static_cast<unsigned>(n));
+
+    static const OSVR_ChannelCount NUM_SENSORS = 5;
+    Eigen::Isometry3d universeXform;
+    auto yaw = gen.yaw();
+    universeXform = Eigen::Translation3d(gen.position(), gen.position(),
+                                         gen.position()) *
+                    Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY());
+    Eigen::Quaterniond universeRotation(
+        Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY()));
+
+    std::vector<SensorTransformCache,
+                Eigen::aligned_allocator<SensorTransformCache>>
+        caches(NUM_SENSORS);
+    for (auto &cache : caches) {
+        cache.offsets = gen.offsets();
+        computeSensorTransforms(universeXform, universeRotation, cache);
+    }
+
+    PoseBatch batch;
+    std::vector<Input> inputs(n);
+    for (int i = 0; i < n; ++i) {
+        auto &in = inputs[i];
+        in.sensor = static_cast<OSVR_ChannelCount>(i % NUM_SENSORS);
+        in.timestamp.seconds = i;
+        in.timestamp.microseconds = 0;
+        for (int c = 0; c < 3; ++c) {
+            in.position[c] = gen.position();
+        }
+        auto q = gen.rotation();
+        in.rotation[0] = static_cast<float>(q.w());
+        in.rotation[1] = static_cast<float>(q.x());
+        in.rotation[2] = static_cast<float>(q.y());
+        in.rotation[3] = static_cast<float>(q.z());
+        batch.add(in.sensor, in.timestamp, in.position, in.rotation,
+                  caches[in.sensor]);
+    }
+    batch.convert();
+
+    REQUIRE(batch.size() == static_cast<std::size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        auto const &in = inputs[i];
+        REQUIRE(batch.getSensor(i) == in.sensor);
+        REQUIRE(batch.getTimestamp(i).seconds == in.timestamp.seconds);
+        auto expected =
+            convertScalar(universeXform, universeRotation,
+                          caches[in.sensor].offsets, in.position, in.rotation);
+        auto const &actual = batch.getPose(i);
+        for (int c = 0; c < 3; ++c) {
+            REQUIRE(actual.translation.data[c] ==
+                    Approx(expected.translation.data[c]).margin(1e-12));
+        }
+        for (int c = 0; c < 4; ++c) {
+            REQUIRE(actual.rotation.data[c] ==
+                    Approx(expected.rotation.data[c]).margin(1e-12));
+        }
+    }
+}
+
+TEST_CASE("PoseBatch starts over empty after clear") {
+    PoseGenerator gen(1);
+    SensorTransformCache cache;
+    cache.offsets = gen.offsets();
+    computeSensorTransforms(Eigen::Isometry3d::Identity(),
+                            Eigen::Quaterniond::Identity(), cache);
+    PoseBatch batch;
+    double position[3] = {1., 2., 3.};
+    float rotation[4] = {1.f, 0.f, 0.f, 0.f};
+    OSVR_TimeValue timestamp = {1, 0};
+    batch.add(0, timestamp, position, rotation, cache);
+    batch.convert();
+    REQUIRE(batch.size() == 1);
+    batch.clear();
+    REQUIRE(batch.empty());
+    batch.add(3, timestamp, position, rotation, cache);
+    batch.convert();
+    REQUIRE(batch.size() == 1);
+    REQUIRE(batch.getSensor(0) == 3);
+}
+
+TEST_CASE("convertPose matches the batch") {
+    PoseGenerator gen(2);
+    SensorTransformCache cache;
+    cache.offsets = gen.offsets();
+    Eigen::Isometry3d universeXform;
+    auto yaw = gen.yaw();
+    universeXform = Eigen::Translation3d(gen.position(), gen.position(),
+                                         gen.position()) *
+                    Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY());
+    computeSensorTransforms(
+        universeXform,
+        Eigen::Quaterniond(Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY())),
+        cache);
+    PoseBatch batch;
+    double position[3] = {gen.position(), gen.position(), gen.position()};
+    auto q = gen.rotation();
+    float rotation[4] = {static_cast<float>(q.w()), static_cast<float>(q.x()),
+                         static_cast<float>(q.y()), static_cast<float>(q.z())};
+    OSVR_TimeValue timestamp = {1, 0};
+    batch.add(0, timestamp, position, rotation, cache);
+    batch.convert();
+
+    Eigen::Vector3d outPosition;
+    Eigen::Quaterniond outRotation;
+    convertPose(cache, Eigen::Vector3d::Map(position),
+                Eigen::Quaterniond(rotation[0], rotation[1], rotation[2],
+                                   rotation[3]),
+                outPosition, outRotation);
+    auto const &pose = batch.getPose(0);
+    for (int c = 0; c < 3; ++c) {
+        REQUIRE(outPosition[c] ==
+                Approx(pose.translation.data[c]).margin(1e-12));
+    }
+    REQUIRE(outRotation.w() == Approx(pose.rotation.data[0]).margin(1e-12));
+    REQUIRE(outRotation.x() == Approx(pose.rotation.data[1]).margin(1e-12));
+    REQUIRE(outRotation.y() == Approx(pose.rotation.data[2]).margin(1e-12));
+    REQUIRE(outRotation.z() == Approx(pose.rotation.data[3]).margin(1e-12));
+}
+
+/// Hidden: run with `ViveTests [benchmark]`. Each iteration converts one pose,
+/// so the times are per pose.
+TEST_CASE("Pose conversion benchmark: cached transform chain against "
+          "rebuilding it",
+          "[.][benchmark]") {
+    PoseGenerator gen(3);
+    static const OSVR_ChannelCount NUM_SENSORS = 8;
+    static const std::size_t NUM_POSES = 1024;
+    auto yaw = gen.yaw();
+    Eigen::Isometry3d universeXform;
+    universeXform = Eigen::Translation3d(gen.position(), gen.position(),
+                                         gen.position()) *
+                    Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY());
+    Eigen::Quaterniond universeRotation(
+        Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitY()));
+    std::vector<SensorTransformCache,
+                Eigen::aligned_allocator<SensorTransformCache>>
+        caches(NUM_SENSORS);
+    for (auto &cache : caches) {
+        cache.offsets = gen.offsets();
+        computeSensorTransforms(universeXform, universeRotation, cache);
+    }
+    std::vector<Input> inputs(NUM_POSES);
+    for (std::size_t i = 0; i < NUM_POSES; ++i) {
+        auto &in = inputs[i];
+        in.sensor = static_cast<OSVR_ChannelCount>(i % NUM_SENSORS);
+        in.timestamp = OSVR_TimeValue{static_cast<OSVR_TimeValue_Seconds>(i),
+                                      0};
+        for (int c = 0; c < 3; ++c) {
+            in.position[c] = gen.position();
+        }
+        auto q = gen.rotation();
+        in.rotation[0] = static_cast<float>(q.w());
+        in.rotation[1] = static_cast<float>(q.x());
+        in.rotation[2] = static_cast<float>(q.y());
+        in.rotation[3] = static_cast<float>(q.z());
+    }
+
+    BENCHMARK_ADVANCED("uncached: chain rebuilt from the offsets")
+    (Catch::Benchmark::Chronometer meter) {
+        meter.measure([&](int i) {
+            auto const &in = inputs[i % NUM_POSES];
+            return convertScalar(universeXform, universeRotation,
+                                 caches[in.sensor].offsets, in.position,
+                                 in.rotation);
+        });
+    };
+
+    BENCHMARK_ADVANCED("cached chain: convertPose")
+    (Catch::Benchmark::Chronometer meter) {
+        meter.measure([&](int i) {
+            auto const &in = inputs[i % NUM_POSES];
+            Eigen::Vector3d position;
+            Eigen::Quaterniond rotation;
+            convertPose(caches[in.sensor], Eigen::Vector3d::Map(in.position),
+                        Eigen::Quaterniond(in.rotation[0], in.rotation[1],
+                                           in.rotation[2], in.rotation[3]),
+                        position, rotation);
+            return position.x() + rotation.w();
+        });
+    };
+
+    /// About one update's worth, the whole batch each time - so divide by
+    /// BATCH_SIZE.
+    static const std::size_t BATCH_SIZE = 16;
+    PoseBatch batch;
+    BENCHMARK("cached chain: PoseBatch, 16 poses") {
+        batch.clear();
+        for (std::size_t i = 0; i < BATCH_SIZE; ++i) {
+            auto const &in = inputs[i];
+            batch.add(in.sensor, in.timestamp, in.position, in.rotation,
+                      caches[in.sensor]);
+        }
+        batch.convert();
+        return batch.getPose(0).translation.data[0];
+    };
+}
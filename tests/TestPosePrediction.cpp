@@ -0,0 +1,272 @@
+/** @file
+    @brief Test - pose prediction along synthetic constant-velocity
+    trajectories.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "PoseBatch.h"
+#include "PosePrediction.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <cmath>
+
+using namespace osvr::vive;
+
+namespace {
+    /// A trajectory with constant linear and angular velocity (the angular
+    /// velocity in the same frame as the pose), sampled in closed form.
+    struct Trajectory {
+        Eigen::Vector3d position0;
+        Eigen::Quaterniond rotation0;
+        Eigen::Vector3d linearVelocity;
+        Eigen::Vector3d angularVelocity;
+
+        Eigen::Vector3d position(double t) const {
+            return position0 + linearVelocity * t;
+        }
+        Eigen::Quaterniond rotation(double t) const {
+            auto rate = angularVelocity.norm();
+            if (rate == 0.) {
+                return rotation0;
+            }
+            return Eigen::Quaterniond(Eigen::AngleAxisd(
+                       rate * t, angularVelocity / rate)) *
+                   rotation0;
+        }
+    };
+
+    Trajectory makeTrajectory() {
+        Trajectory ret;
+        ret.position0 = Eigen::Vector3d(0.3, 1.6, -0.4);
+        ret.rotation0 = Eigen::Quaterniond(
+            Eigen::AngleAxisd(0.7, Eigen::Vector3d(1., 2., -1.).normalized()));
+        /// Brisk head motion: a meter per second, and a few hundred degrees
+        /// per second about a tilted axis.
+        ret.linearVelocity = Eigen::Vector3d(0.8, -0.1, 0.5);
+        ret.angularVelocity = Eigen::Vector3d(1.5, 4., -0.5);
+        return ret;
+    }
+
+    /// Angle between two rotations, in radians.
+    double angleBetween(Eigen::Quaterniond const &a,
+                        Eigen::Quaterniond const &b) {
+        return a.angularDistance(b);
+    }
+
+    OSVR_TimeValue timeFromSeconds(double t) {
+        OSVR_TimeValue ret;
+        ret.seconds = static_cast<OSVR_TimeValue_Seconds>(std::floor(t));
+        ret.microseconds = static_cast<OSVR_TimeValue_Microseconds>(
+            std::round((t - std::floor(t)) * 1e6));
+        return ret;
+    }
+
+    void toFloats(Eigen::Quaterniond const &q, float rotation[4]) {
+        rotation[0] = static_cast<float>(q.w());
+        rotation[1] = static_cast<float>(q.x());
+        rotation[2] = static_cast<float>(q.y());
+        rotation[3] = static_cast<float>(q.z());
+    }
+    /// Non-trivial offsets and universe, so a prediction made in the wrong
+    /// frame shows.
+    SensorTransformCache
+    makeCache(Eigen::Vector3d const &driverFromHeadTranslation) {
+        SensorTransformCache cache;
+        auto &offsets = cache.offsets;
+        Eigen::Quaterniond worldFromDriver(Eigen::AngleAxisd(
+            -0.4, Eigen::Vector3d(0., 1., 0.2).normalized()));
+        Eigen::Quaterniond driverFromHead(
+            Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitX()));
+        offsets.qWorldFromDriverRotation.w = worldFromDriver.w();
+        offsets.qWorldFromDriverRotation.x = worldFromDriver.x();
+        offsets.qWorldFromDriverRotation.y = worldFromDriver.y();
+        offsets.qWorldFromDriverRotation.z = worldFromDriver.z();
+        offsets.qDriverFromHeadRotation.w = driverFromHead.w();
+        offsets.qDriverFromHeadRotation.x = driverFromHead.x();
+        offsets.qDriverFromHeadRotation.y = driverFromHead.y();
+        offsets.qDriverFromHeadRotation.z = driverFromHead.z();
+        offsets.vecWorldFromDriverTranslation[0] = 1.;
+        offsets.vecWorldFromDriverTranslation[1] = 0.5;
+        offsets.vecWorldFromDriverTranslation[2] = -2.;
+        Eigen::Vector3d::Map(offsets.vecDriverFromHeadTranslation) =
+            driverFromHeadTranslation;
+        Eigen::Isometry3d universeXform;
+        universeXform = Eigen::Translation3d(0.2, 0., -0.3) *
+                        Eigen::AngleAxisd(1.1, Eigen::Vector3d::UnitY());
+        Eigen::Quaterniond universeRotation(
+            Eigen::AngleAxisd(1.1, Eigen::Vector3d::UnitY()));
+        computeSensorTransforms(universeXform, universeRotation, cache);
+        return cache;
+    }
+
+    static const double T0 = 3.5;
+
+    /// Fills @p batch with two converted poses: 0 sampled from @p traj at T0
+    /// and predicted dt ahead, and 1 sampled at T0 + dt.
+    void predictAlongside(Trajectory const &traj,
+                          SensorTransformCache const &cache, double dt,
+                          PoseBatch &batch) {
+        auto sampled = timeFromSeconds(T0);
+        auto target = timeFromSeconds(T0 + dt);
+        double position[3];
+        float rotation[4];
+        Eigen::Vector3d::Map(position) = traj.position(T0);
+        toFloats(traj.rotation(T0), rotation);
+        batch.add(0, sampled, position, rotation, cache);
+        batch.predict(0, traj.linearVelocity.data(),
+                      traj.angularVelocity.data(), target);
+        Eigen::Vector3d::Map(position) = traj.position(T0 + dt);
+        toFloats(traj.rotation(T0 + dt), rotation);
+        batch.add(1, target, position, rotation, cache);
+        batch.convert();
+    }
+
+    double distanceBetween(OSVR_Pose3 const &a, OSVR_Pose3 const &b) {
+        return (Eigen::Vector3d::Map(a.translation.data) -
+                Eigen::Vector3d::Map(b.translation.data))
+            .norm();
+    }
+} // namespace
+
+TEST_CASE("predictPose follows a constant-velocity trajectory exactly") {
+    auto traj = makeTrajectory();
+    /// Sample times and horizons around a 90Hz frame.
+    auto t0 = GENERATE(0., 0.011, 1.25);
+    auto dt = GENERATE(0., 0.005, 0.011, 0.02, 0.05);
+
+    Eigen::Vector3d position = traj.position(t0);
+    Eigen::Quaterniond rotation = traj.rotation(t0);
+    predictPose(position, rotation, traj.linearVelocity,
+                traj.angularVelocity, dt);
+
+    REQUIRE((position - traj.position(t0 + dt)).norm() ==
+            Approx(0.).margin(1e-12));
+    REQUIRE(angleBetween(rotation, traj.rotation(t0 + dt)) ==
+            Approx(0.).margin(1e-9));
+}
+
+TEST_CASE("quatExp handles rates near zero") {
+    Eigen::Vector3d tiny(1e-14, -2e-14, 0.);
+    auto q = quatExp(tiny);
+    REQUIRE(q.norm() == Approx(1.));
+    REQUIRE(angleBetween(q, Eigen::Quaterniond::Identity()) ==
+            Approx(0.).margin(1e-12));
+}
+
+TEST_CASE("PoseBatch::predict lands on the trajectory in the universe") {
+    auto traj = makeTrajectory();
+    auto dt = GENERATE(0.005, 0.011, 0.02, 0.05);
+
+    auto cache = makeCache(Eigen::Vector3d(0., -0.02, 0.08));
+    PoseBatch batch;
+    predictAlongside(traj, cache, dt, batch);
+
+    auto target = timeFromSeconds(T0 + dt);
+    REQUIRE(batch.getTimestamp(0).seconds == target.seconds);
+    REQUIRE(batch.getTimestamp(0).microseconds == target.microseconds);
+    auto const &predicted = batch.getPose(0);
+    auto const &actual = batch.getPose(1);
+    /// The float rotations place the head offset too.
+    REQUIRE(distanceBetween(predicted, actual) == Approx(0.).margin(1e-7));
+    Eigen::Quaterniond predictedRotation(
+        predicted.rotation.data[0], predicted.rotation.data[1],
+        predicted.rotation.data[2], predicted.rotation.data[3]);
+    Eigen::Quaterniond actualRotation(
+        actual.rotation.data[0], actual.rotation.data[1],
+        actual.rotation.data[2], actual.rotation.data[3]);
+    /// The input rotations are floats, so this is as close as they agree.
+    REQUIRE(angleBetween(predictedRotation, actualRotation) ==
+            Approx(0.).margin(1e-6));
+}
+
+TEST_CASE("PoseBatch::predict swings an offset head around the tracked "
+          "point") {
+    /// Turning in place: only the lever arm moves the head.
+    auto traj = makeTrajectory();
+    traj.linearVelocity = Eigen::Vector3d::Zero();
+    auto dt = GENERATE(0.005, 0.011, 0.02, 0.05);
+
+    auto cache = makeCache(Eigen::Vector3d(0.03, -0.05, 0.15));
+    PoseBatch batch;
+    predictAlongside(traj, cache, dt, batch);
+
+    REQUIRE(distanceBetween(batch.getPose(0), batch.getPose(1)) ==
+            Approx(0.).margin(1e-7));
+    /// ...which is a real distance: the head moves ~0.7 m/s.
+    Eigen::Vector3d position;
+    Eigen::Quaterniond rotation;
+    convertPose(cache, traj.position(T0), traj.rotation(T0), position,
+                rotation);
+    REQUIRE((Eigen::Vector3d::Map(batch.getPose(0).translation.data) -
+             position)
+                .norm() > 0.5 * dt);
+}
+
+TEST_CASE("headLinearVelocity is the rate the converted head moves") {
+    auto traj = makeTrajectory();
+    Eigen::Vector3d driverFromHeadTranslation(0.03, -0.05, 0.15);
+    auto head = [&](double t) -> Eigen::Vector3d {
+        return traj.position(t) +
+               traj.rotation(t) * driverFromHeadTranslation;
+    };
+    static const double H = 1e-5;
+    Eigen::Vector3d expected = (head(T0 + H) - head(T0 - H)) / (2. * H);
+    Eigen::Vector3d velocity =
+        headLinearVelocity(traj.linearVelocity, traj.angularVelocity,
+                           traj.rotation(T0), driverFromHeadTranslation);
+    REQUIRE((velocity - expected).norm() == Approx(0.).margin(1e-6));
+    /// Without the lever arm it'd be well off.
+    REQUIRE((traj.linearVelocity - expected).norm() > 0.5);
+}
+
+TEST_CASE("PoseBatch::predict without velocity only retimes the pose") {
+    SensorTransformCache cache;
+    cache.offsets.qWorldFromDriverRotation.w = 1.;
+    cache.offsets.qWorldFromDriverRotation.x = 0.;
+    cache.offsets.qWorldFromDriverRotation.y = 0.;
+    cache.offsets.qWorldFromDriverRotation.z = 0.;
+    cache.offsets.qDriverFromHeadRotation =
+        cache.offsets.qWorldFromDriverRotation;
+    for (int c = 0; c < 3; ++c) {
+        cache.offsets.vecWorldFromDriverTranslation[c] = 0.;
+        cache.offsets.vecDriverFromHeadTranslation[c] = 0.;
+    }
+    computeSensorTransforms(Eigen::Isometry3d::Identity(),
+                            Eigen::Quaterniond::Identity(), cache);
+    PoseBatch batch;
+    double position[3] = {1., 2., 3.};
+    float rotation[4] = {1.f, 0.f, 0.f, 0.f};
+    double zero[3] = {0., 0., 0.};
+    batch.add(0, timeFromSeconds(2.), position, rotation, cache);
+    batch.predict(0, zero, zero, timeFromSeconds(2.03));
+    batch.convert();
+    auto const &pose = batch.getPose(0);
+    for (int c = 0; c < 3; ++c) {
+        REQUIRE(pose.translation.data[c] == Approx(position[c]));
+    }
+    REQUIRE(pose.rotation.data[0] == Approx(1.));
+    REQUIRE(batch.getTimestamp(0).microseconds == 30000);
+}
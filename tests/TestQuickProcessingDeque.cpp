@@ -0,0 +1,133 @@
+/** @file
+    @brief Test - the swapping report queue against the element-wise copy it
+    replaced, grabbing while producers submit.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "BackgroundThreads.h"
+#include "QuickProcessingDeque.h"
+#include "VerifyLocked.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace osvr::vive;
+
+namespace {
+    /// The size of a packed tracking report.
+    struct BenchReport {
+        std::uint64_t words[8];
+    };
+
+    /// QuickProcessingDeque as it was before it swapped: grabItems moves
+    /// the items one at a time from a deque into the work vector, holding
+    /// the lock throughout.
+    template <typename T, typename LockType = std::lock_guard<std::mutex>>
+    class ElementwiseDeque {
+      public:
+        using lock_type = LockType;
+
+        bool submitNew(T const &v, lock_type &lock) {
+            if (verifyLocked<lock_type>(lock)) {
+                deque_.push_back(v);
+            }
+            return true;
+        }
+
+        std::size_t grabItems(lock_type &lock) {
+            if (verifyLocked<lock_type>(lock)) {
+                vector_.clear();
+                auto numItems = deque_.size();
+                for (std::size_t i = 0; i < numItems; ++i) {
+                    vector_.push_back(deque_.front());
+                    deque_.pop_front();
+                }
+                return numItems;
+            }
+            return 0;
+        }
+
+        std::vector<T> const &accessWorkItems() const { return vector_; }
+
+      private:
+        std::deque<T> deque_;
+        std::vector<T> vector_;
+    };
+
+    /// The main thread's grab, with producers submitting flat out - so what
+    /// piles up between grabs, and so the time in the lock, depends on how
+    /// long the last grab held them off.
+    template <typename Queue>
+    void benchmarkGrab(std::string const &name, std::size_t producers) {
+        Queue queue;
+        std::mutex mut;
+        const BenchReport report = {};
+        BackgroundThreads threads(producers, 0., [&](std::size_t) {
+            std::lock_guard<std::mutex> lock(mut);
+            queue.submitNew(report, lock);
+        });
+        BENCHMARK(name + ", " + std::to_string(producers) + " producers") {
+            std::lock_guard<std::mutex> lock(mut);
+            return queue.grabItems(lock);
+        };
+    }
+} // namespace
+
+TEST_CASE("QuickProcessingDeque hands over everything submitted, in order") {
+    QuickProcessingDeque<int> queue;
+    std::mutex mut;
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        for (int i = 0; i < 5; ++i) {
+            queue.submitNew(i, lock);
+        }
+        REQUIRE(queue.grabItems(lock) == 5);
+    }
+    REQUIRE(queue.accessWorkItems() == std::vector<int>({0, 1, 2, 3, 4}));
+
+    SECTION("and only what came after, next time") {
+        std::lock_guard<std::mutex> lock(mut);
+        queue.submitNew(5, lock);
+        REQUIRE(queue.grabItems(lock) == 1);
+        REQUIRE(queue.accessWorkItems() == std::vector<int>({5}));
+        REQUIRE(queue.grabItems(lock) == 0);
+    }
+}
+
+/// Hidden: run with `ViveTests [benchmark]`.
+TEST_CASE("QuickProcessingDeque grab: swapping against element-wise copy",
+          "[.][benchmark]") {
+    for (std::size_t producers : {1, 2, 3, 4}) {
+        benchmarkGrab<ElementwiseDeque<BenchReport>>("element-wise",
+                                                     producers);
+        benchmarkGrab<QuickProcessingDeque<BenchReport>>("swap", producers);
+    }
+}
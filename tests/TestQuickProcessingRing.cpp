@@ -0,0 +1,195 @@
+/** @file
+    @brief Test - the lock-free report ring's overflow policies, and a
+    benchmark against the mutex-controlled deque.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "BackgroundThreads.h"
+#include "QuickProcessingDeque.h"
+#include "QuickProcessingRing.h"
+#include "TrackingLanes.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace osvr::vive;
+
+namespace {
+    /// The size of a packed tracking report.
+    struct BenchReport {
+        std::uint64_t words[8];
+    };
+
+    /// One report's trip through the queue - submit, grab, read - while
+    /// sensor threads each submit at 1 kHz, as the driver's do. Submits
+    /// through the tracker's helper, so only the deque takes the mutex.
+    template <typename Queue>
+    void benchmarkTrip(std::string const &name, std::size_t sensors) {
+        Queue queue(4096, QueueOverflowPolicy::DropOldest);
+        std::mutex mut;
+        const BenchReport report = {};
+        BackgroundThreads threads(sensors, 1000., [&](std::size_t) {
+            submitToQueue(queue, mut, report);
+        });
+        BENCHMARK(name + ", " + std::to_string(sensors) + " sensors") {
+            submitToQueue(queue, mut, report);
+            {
+                std::lock_guard<std::mutex> lock(mut);
+                queue.grabItems(lock);
+            }
+            return queue.accessWorkItems().size();
+        };
+    }
+
+    /// A sensor thread's submit, while the main thread grabs flat out - the
+    /// contention the driver's threads see.
+    template <typename Queue>
+    void benchmarkContendedSubmit(std::string const &name) {
+        Queue queue(4096, QueueOverflowPolicy::DropOldest);
+        std::mutex mut;
+        const BenchReport report = {};
+        BackgroundThreads update(1, 0., [&](std::size_t) {
+            std::lock_guard<std::mutex> lock(mut);
+            queue.grabItems(lock);
+        });
+        BENCHMARK(name + ", submit while grabbing") {
+            return submitToQueue(queue, mut, report);
+        };
+    }
+} // namespace
+
+TEST_CASE("QuickProcessingRing reports the policy it can honor") {
+    REQUIRE(QuickProcessingRing<int>(8, QueueOverflowPolicy::DropOldest)
+                .policy() == QueueOverflowPolicy::DropOldest);
+    REQUIRE(QuickProcessingRing<int>(8, QueueOverflowPolicy::DropNewest)
+                .policy() == QueueOverflowPolicy::DropNewest);
+    REQUIRE(QuickProcessingRing<int>(8, QueueOverflowPolicy::NeverDrop)
+                .policy() == QueueOverflowPolicy::DropNewest);
+}
+
+TEST_CASE("QuickProcessingRing drops the newest when full") {
+    QuickProcessingRing<int> ring(4, QueueOverflowPolicy::DropNewest);
+    REQUIRE(ring.capacity() == 4);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(ring.submitNew(i));
+    }
+    REQUIRE_FALSE(ring.submitNew(4));
+    REQUIRE_FALSE(ring.submitNew(5));
+    REQUIRE(ring.getDroppedCount() == 2);
+    REQUIRE(ring.grabItems() == 4);
+    REQUIRE(ring.accessWorkItems() == std::vector<int>({0, 1, 2, 3}));
+}
+
+TEST_CASE("QuickProcessingRing drops the oldest when full") {
+    QuickProcessingRing<int> ring(4, QueueOverflowPolicy::DropOldest);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(ring.submitNew(i));
+    }
+    REQUIRE_FALSE(ring.submitNew(4));
+    REQUIRE_FALSE(ring.submitNew(5));
+    REQUIRE(ring.getDroppedCount() == 2);
+    REQUIRE(ring.grabItems() == 4);
+    REQUIRE(ring.accessWorkItems() == std::vector<int>({2, 3, 4, 5}));
+
+    SECTION("and keeps working for later laps") {
+        for (int i = 6; i < 13; ++i) {
+            ring.submitNew(i);
+        }
+        REQUIRE(ring.getDroppedCount() == 5);
+        REQUIRE(ring.grabItems() == 4);
+        REQUIRE(ring.accessWorkItems() ==
+                std::vector<int>({9, 10, 11, 12}));
+        REQUIRE(ring.grabItems() == 0);
+    }
+}
+
+TEST_CASE("QuickProcessingRing loses nothing uncounted with producers "
+          "evicting while the consumer grabs") {
+    auto policy = GENERATE(QueueOverflowPolicy::DropOldest,
+                           QueueOverflowPolicy::DropNewest);
+    static const int NUM_PRODUCERS = 4;
+    static const std::uint32_t PER_PRODUCER = 100000;
+    /// Small, so it's full a lot of the time.
+    QuickProcessingRing<std::uint64_t> ring(16, policy);
+
+    std::atomic<int> running{NUM_PRODUCERS};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < NUM_PRODUCERS; ++p) {
+        producers.emplace_back([&, p] {
+            for (std::uint32_t i = 0; i < PER_PRODUCER; ++i) {
+                ring.submitNew((std::uint64_t(p) << 32) | i);
+            }
+            --running;
+        });
+    }
+
+    std::uint64_t received = 0;
+    std::vector<std::int64_t> lastSeen(NUM_PRODUCERS, -1);
+    bool inOrder = true;
+    auto take = [&] {
+        ring.grabItems();
+        for (auto item : ring.accessWorkItems()) {
+            auto p = static_cast<std::size_t>(item >> 32);
+            auto i = static_cast<std::int64_t>(item & 0xffffffff);
+            /// Each producer's items arrive in order, none twice.
+            inOrder = inOrder && i > lastSeen[p];
+            lastSeen[p] = i;
+            ++received;
+        }
+    };
+    while (running > 0) {
+        take();
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    take();
+
+    REQUIRE(inOrder);
+    REQUIRE(received + ring.getDroppedCount() ==
+            NUM_PRODUCERS * std::uint64_t(PER_PRODUCER));
+}
+
+/// Hidden: run with `ViveTests [benchmark]`.
+TEST_CASE("QuickProcessingRing against the mutex-controlled deque, sensors "
+          "at 1 kHz",
+          "[.][benchmark]") {
+    for (std::size_t sensors : {4, 8, 16}) {
+        benchmarkTrip<QuickProcessingDeque<BenchReport>>("mutex + deque",
+                                                         sensors);
+        benchmarkTrip<QuickProcessingRing<BenchReport>>("lock-free ring",
+                                                        sensors);
+    }
+    benchmarkContendedSubmit<QuickProcessingDeque<BenchReport>>(
+        "mutex + deque");
+    benchmarkContendedSubmit<QuickProcessingRing<BenchReport>>(
+        "lock-free ring");
+}
@@ -0,0 +1,137 @@
+/** @file
+    @brief Test - the seqlock table's reads under concurrent writes.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "SeqlockTable.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace osvr::vive;
+
+namespace {
+    /// Every word holds the same value, so a torn read shows as a mismatch.
+    struct Value {
+        std::uint64_t words[9];
+    };
+
+    Value makeValue(std::uint64_t n) {
+        Value ret;
+        for (auto &word : ret.words) {
+            word = n;
+        }
+        return ret;
+    }
+
+    bool consistent(Value const &v) {
+        for (auto word : v.words) {
+            if (word != v.words[0]) {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+TEST_CASE("SeqlockTable reads back what was written") {
+    SeqlockTable<Value> table(4);
+    Value v = makeValue(7);
+    REQUIRE_FALSE(table.read(0, v));
+    REQUIRE(v.words[0] == 7);
+    REQUIRE(table.write(1, makeValue(42)));
+    REQUIRE(table.read(1, v));
+    REQUIRE(v.words[0] == 42);
+    REQUIRE(table.write(1, makeValue(43)));
+    REQUIRE(table.read(1, v));
+    REQUIRE(v.words[0] == 43);
+    REQUIRE_FALSE(table.write(4, v));
+    REQUIRE_FALSE(table.read(4, v));
+}
+
+TEST_CASE("SeqlockTable reads are consistent with one writer and several "
+          "readers") {
+    static const std::size_t ENTRIES = 3;
+    static const std::uint64_t WRITES = 200000;
+    static const int READERS = 4;
+    SeqlockTable<Value> table(ENTRIES);
+
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> torn{0};
+    std::atomic<std::uint64_t> backwards{0};
+    std::atomic<std::uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r) {
+        readers.emplace_back([&] {
+            std::uint64_t last[ENTRIES] = {};
+            std::uint64_t myReads = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                for (std::size_t i = 0; i < ENTRIES; ++i) {
+                    Value v;
+                    if (!table.read(i, v)) {
+                        continue;
+                    }
+                    ++myReads;
+                    if (!consistent(v)) {
+                        ++torn;
+                    } else if (v.words[0] < last[i]) {
+                        /// Values only ever increase: reading an older one
+                        /// after a newer one means a stale copy got through.
+                        ++backwards;
+                    } else {
+                        last[i] = v.words[0];
+                    }
+                }
+            }
+            reads += myReads;
+        });
+    }
+
+    for (std::uint64_t n = 1; n <= WRITES; ++n) {
+        table.write(n % ENTRIES, makeValue(n));
+    }
+    done.store(true, std::memory_order_release);
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    CAPTURE(reads.load(), table.getFailedReadCount());
+    REQUIRE(torn == 0);
+    REQUIRE(backwards == 0);
+    /// Only one writer, so no write is ever contended.
+    REQUIRE(table.getContendedWriteCount() == 0);
+    /// The last values written are what's there now.
+    for (std::size_t i = 0; i < ENTRIES; ++i) {
+        Value v;
+        REQUIRE(table.read(i, v));
+        REQUIRE(consistent(v));
+        REQUIRE(v.words[0] % ENTRIES == i);
+        REQUIRE(v.words[0] > WRITES - ENTRIES);
+    }
+}
@@ -0,0 +1,203 @@
+/** @file
+    @brief Test - publishing poses to shared memory and reading them back,
+    and a benchmark of that read against a VRPN round trip.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "BackgroundThreads.h"
+#include "SharedPosePublisher.h"
+#include "ViveSharedPoses.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+#ifdef OSVRVIVE_TESTS_HAVE_VRPN
+#include <vrpn_Connection.h>
+#include <vrpn_Tracker.h>
+#endif
+
+// Standard includes
+#include <cstdint>
+#include <string>
+
+#include <unistd.h>
+
+using namespace osvr::vive;
+
+namespace {
+    /// Unique per test run, so parallel runs don't share a segment.
+    std::string segmentName() {
+        return "/osvr_vive_tests_" + std::to_string(getpid());
+    }
+
+    OSVR_Pose3 makePose(double x) {
+        OSVR_Pose3 ret = {};
+        ret.translation.data[0] = x;
+        ret.rotation.data[0] = 1.;
+        return ret;
+    }
+
+    /// A publisher and a reader's mapping of its segment.
+    struct SharedPoses {
+        SharedPoses() {
+            publisher.open(segmentName());
+            if (publisher) {
+                reader = osvrViveOpenSharedPoses(segmentName().c_str());
+            }
+        }
+        ~SharedPoses() {
+            if (reader) {
+                osvrViveCloseSharedPoses(reader);
+            }
+        }
+        SharedPoses(SharedPoses const &) = delete;
+        SharedPoses &operator=(SharedPoses const &) = delete;
+
+        SharedPosePublisher publisher;
+        OSVRVive_SharedPoses const *reader = nullptr;
+    };
+
+#ifdef OSVRVIVE_TESTS_HAVE_VRPN
+    static const int VRPN_BENCH_PORT = 3897;
+
+    /// A VRPN tracker server and a remote connected to it over localhost -
+    /// the path a client's pose takes without the shared segment.
+    class VrpnRoundTrip {
+      public:
+        VrpnRoundTrip()
+            : connection_(vrpn_create_server_connection(VRPN_BENCH_PORT)),
+              server_("Tracker0", connection_),
+              remote_(("Tracker0@localhost:" + std::to_string(VRPN_BENCH_PORT))
+                          .c_str()) {
+            remote_.register_change_handler(this, &VrpnRoundTrip::handle);
+            while (!remote_.connectionPtr()->connected()) {
+                mainloop();
+            }
+        }
+        ~VrpnRoundTrip() { connection_->removeReference(); }
+        VrpnRoundTrip(VrpnRoundTrip const &) = delete;
+        VrpnRoundTrip &operator=(VrpnRoundTrip const &) = delete;
+
+        /// Sends a pose and spins until the remote has it.
+        double trip() {
+            ++sent_;
+            timeval now;
+            vrpn_gettimeofday(&now, nullptr);
+            const vrpn_float64 position[3] = {double(sent_), 0., 0.};
+            const vrpn_float64 rotation[4] = {0., 0., 0., 1.};
+            server_.report_pose(0, now, position, rotation);
+            while (received_ != sent_) {
+                mainloop();
+            }
+            return lastX_;
+        }
+
+      private:
+        void mainloop() {
+            server_.mainloop();
+            connection_->mainloop();
+            remote_.mainloop();
+        }
+        static void VRPN_CALLBACK handle(void *userdata,
+                                         const vrpn_TRACKERCB info) {
+            auto self = static_cast<VrpnRoundTrip *>(userdata);
+            self->lastX_ = info.pos[0];
+            self->received_ = static_cast<std::uint64_t>(info.pos[0]);
+        }
+
+        vrpn_Connection *connection_;
+        vrpn_Tracker_Server server_;
+        vrpn_Tracker_Remote remote_;
+        std::uint64_t sent_ = 0;
+        std::uint64_t received_ = 0;
+        double lastX_ = 0.;
+    };
+#endif
+} // namespace
+
+TEST_CASE("Shared poses read back as published") {
+    SharedPoses shm;
+    REQUIRE(shm.publisher);
+    REQUIRE(shm.reader);
+
+    OSVRVive_SharedPose pose;
+    REQUIRE_FALSE(osvrViveReadSharedPose(shm.reader, 2, &pose));
+
+    OSVR_TimeValue timestamp = {12, 345};
+    const double linear[3] = {1., 2., 3.};
+    const double angular[3] = {4., 5., 6.};
+    shm.publisher.publish(2, makePose(0.5), timestamp, 200, linear,
+                          angular);
+    REQUIRE(osvrViveReadSharedPose(shm.reader, 2, &pose));
+    REQUIRE(pose.poseIsValid);
+    REQUIRE(pose.velocityIsValid);
+    REQUIRE(pose.translation[0] == 0.5);
+    REQUIRE(pose.linearVelocity[2] == 3.);
+    REQUIRE(pose.timestampSeconds == 12);
+    REQUIRE(pose.timestampMicroseconds == 345);
+    REQUIRE(pose.trackingResult == 200);
+
+    SECTION("then invalid") {
+        OSVR_TimeValue later = {12, 1345};
+        shm.publisher.publishInvalid(2, later, 101);
+        REQUIRE(osvrViveReadSharedPose(shm.reader, 2, &pose));
+        REQUIRE_FALSE(pose.poseIsValid);
+        REQUIRE(pose.timestampMicroseconds == 1345);
+        REQUIRE(pose.trackingResult == 101);
+    }
+
+    SECTION("out of range") {
+        shm.publisher.publish(OSVRVIVE_SHARED_POSES_MAX_SENSORS, makePose(1.),
+                              timestamp, 200);
+        REQUIRE_FALSE(osvrViveReadSharedPose(
+            shm.reader, OSVRVIVE_SHARED_POSES_MAX_SENSORS, &pose));
+    }
+}
+
+/// Hidden: run with `ViveTests [benchmark]`. The VRPN half only if the tests
+/// were built with VRPN.
+TEST_CASE("Shared pose benchmark: seqlock read against a VRPN round trip",
+          "[.][benchmark]") {
+    SharedPoses shm;
+    REQUIRE(shm.reader);
+    OSVR_TimeValue timestamp = {1, 0};
+    shm.publisher.publish(0, makePose(1.), timestamp, 200);
+    OSVRVive_SharedPose pose;
+    BENCHMARK("seqlock read, idle") {
+        return osvrViveReadSharedPose(shm.reader, 0, &pose);
+    };
+    {
+        /// The server's main loop publishes at most this often.
+        BackgroundThreads publisher(1, 1000., [&](std::size_t) {
+            shm.publisher.publish(0, makePose(2.), timestamp, 200);
+        });
+        BENCHMARK("seqlock read, publishing at 1 kHz") {
+            return osvrViveReadSharedPose(shm.reader, 0, &pose);
+        };
+    }
+#ifdef OSVRVIVE_TESTS_HAVE_VRPN
+    VrpnRoundTrip vrpn;
+    BENCHMARK("VRPN tracker round trip over localhost") {
+        return vrpn.trip();
+    };
+#endif
+}
@@ -0,0 +1,219 @@
+/** @file
+    @brief Test - the order tracking reports come out of their lanes.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "BackgroundThreads.h"
+#include "TrackingLanes.h"
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+
+// Standard includes
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace osvr::vive;
+
+namespace {
+    /// Just enough of a TrackingReport to route and tell apart.
+    struct Report {
+        enum class Kind { Pose, UniverseChange };
+        Kind kind = Kind::Pose;
+        std::uint32_t sensor = 0;
+        int id = 0;
+    };
+
+    Report pose(std::uint32_t sensor, int id) {
+        Report ret;
+        ret.sensor = sensor;
+        ret.id = id;
+        return ret;
+    }
+
+    Report universeChange(int id) {
+        Report ret;
+        ret.kind = Report::Kind::UniverseChange;
+        ret.id = id;
+        return ret;
+    }
+
+    /// Submits the way ViveDriverHost::submitTrackingReport does: poses to
+    /// the table when coalescing, the queue otherwise.
+    template <typename Lanes>
+    void submitPose(Lanes &lanes, std::mutex &mut, Report const &report,
+                    bool coalesce) {
+        auto &lane = lanes.laneFor(report.sensor);
+        if (coalesce) {
+            std::lock_guard<std::mutex> lock(mut);
+            lane.latest.submitNew(report.sensor, report, lock);
+        } else {
+            submitToQueue(lane.reports, mut, report);
+        }
+    }
+
+    /// Grabs and drains the lanes in the order ViveDriverHost::update()
+    /// does, recording the order the reports would be sent in.
+    /// @param between called after the HMD lane is first drained, before
+    /// the other lane is grabbed.
+    template <typename Lanes>
+    std::vector<int> updateOrder(Lanes &lanes, std::mutex &mut,
+                                 std::function<void()> between = nullptr) {
+        std::vector<int> ret;
+        auto record = [&](Report const &report) { ret.push_back(report.id); };
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            lanes.hmd().grabItems(lock);
+        }
+        auto hmdAtUniverseChange =
+            lanes.hmd().drainUntilUniverseChange(record);
+        if (between) {
+            between();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            lanes.others().grabItems(lock);
+            if (!hmdAtUniverseChange) {
+                lanes.hmd().grabItems(lock);
+            }
+        }
+        lanes.drainInOrder(hmdAtUniverseChange, record);
+        return ret;
+    }
+
+    using BenchQueue = QuickProcessingDeque<Report>;
+    const QueueConfig BENCH_QUEUE_CONFIG{4096,
+                                         QueueOverflowPolicy::DropOldest};
+
+    /// An HMD pose from submit to handled, while pucks submit flat out: all
+    /// in one lane, behind whatever the pucks queued since the last update.
+    void benchmarkSharedLane(std::size_t pucks) {
+        TrackingLane<Report, BenchQueue> lane(BENCH_QUEUE_CONFIG);
+        std::mutex mut;
+        BackgroundThreads threads(pucks, 0., [&](std::size_t i) {
+            submitToQueue(lane.reports, mut,
+                          pose(static_cast<std::uint32_t>(i + 1), 0));
+        });
+        BENCHMARK("one shared lane, " + std::to_string(pucks) + " pucks") {
+            submitToQueue(lane.reports, mut, pose(0, 1));
+            {
+                std::lock_guard<std::mutex> lock(mut);
+                lane.grabItems(lock);
+            }
+            int handled = 0;
+            lane.drain([&](Report const &report) { handled += report.id; });
+            return handled;
+        };
+    }
+
+    /// The same with the HMD in its own lane, grabbed and drained first.
+    void benchmarkHmdLane(std::size_t pucks) {
+        TrackingLanes<Report, BenchQueue> lanes(BENCH_QUEUE_CONFIG);
+        std::mutex mut;
+        BackgroundThreads threads(pucks, 0., [&](std::size_t i) {
+            submitPose(lanes, mut, pose(static_cast<std::uint32_t>(i + 1), 0),
+                       false);
+        });
+        BENCHMARK("HMD lane, " + std::to_string(pucks) + " pucks") {
+            submitPose(lanes, mut, pose(0, 1), false);
+            {
+                std::lock_guard<std::mutex> lock(mut);
+                lanes.hmd().grabItems(lock);
+            }
+            int handled = 0;
+            lanes.hmd().drain(
+                [&](Report const &report) { handled += report.id; });
+            return handled;
+        };
+    }
+} // namespace
+
+TEMPLATE_TEST_CASE("TrackingLanes send the HMD first, but nothing past a "
+                   "universe change",
+                   "", QuickProcessingDeque<Report>,
+                   QuickProcessingRing<Report>) {
+    TrackingLanes<Report, TestType> lanes(
+        QueueConfig{64, QueueOverflowPolicy::DropOldest});
+    std::mutex mut;
+
+    SECTION("routing") {
+        REQUIRE(&lanes.laneFor(0) == &lanes.hmd());
+        REQUIRE(&lanes.laneFor(1) == &lanes.others());
+        REQUIRE(&lanes.laneFor(3) == &lanes.others());
+    }
+
+    SECTION("queued") {
+        /// Controllers report first, the HMD and a universe change later -
+        /// the HMD lane still goes out first, but each lane's reports from
+        /// before the change go out before either copy of it.
+        submitPose(lanes, mut, pose(1, 10), false);
+        submitPose(lanes, mut, pose(2, 11), false);
+        submitPose(lanes, mut, pose(0, 1), false);
+        lanes.submitUniverseChange(mut, universeChange(2), false);
+        submitPose(lanes, mut, pose(1, 12), false);
+        submitPose(lanes, mut, pose(0, 3), false);
+        REQUIRE(updateOrder(lanes, mut) ==
+                std::vector<int>({1, 10, 11, 2, 3, 2, 12}));
+        REQUIRE(updateOrder(lanes, mut).empty());
+    }
+
+    SECTION("coalesced") {
+        /// Only the newest pose per sensor survives - except the poses that
+        /// came before the universe change, which are flushed into each
+        /// lane's queue ahead of it.
+        submitPose(lanes, mut, pose(1, 10), true);
+        submitPose(lanes, mut, pose(0, 1), true);
+        lanes.submitUniverseChange(mut, universeChange(2), true);
+        submitPose(lanes, mut, pose(0, 3), true);
+        submitPose(lanes, mut, pose(0, 4), true);
+        submitPose(lanes, mut, pose(1, 11), true);
+        REQUIRE(updateOrder(lanes, mut) ==
+                std::vector<int>({1, 10, 2, 4, 2, 11}));
+    }
+
+    SECTION("universe change after the HMD lane was drained") {
+        /// Only the grab of the other lane catches the change - the HMD
+        /// lane is grabbed again with it, so the HMD pose from before the
+        /// change still goes out before it.
+        submitPose(lanes, mut, pose(0, 1), false);
+        submitPose(lanes, mut, pose(1, 10), false);
+        REQUIRE(updateOrder(lanes, mut, [&] {
+                    submitPose(lanes, mut, pose(0, 2), false);
+                    lanes.submitUniverseChange(mut, universeChange(3), false);
+                    submitPose(lanes, mut, pose(0, 4), false);
+                    submitPose(lanes, mut, pose(1, 11), false);
+                }) == std::vector<int>({1, 2, 10, 3, 4, 3, 11}));
+    }
+}
+
+/// Hidden: run with `ViveTests [benchmark]`.
+TEST_CASE("HMD pose submit-to-drain latency with pucks submitting",
+          "[.][benchmark]") {
+    for (std::size_t pucks : {1, 2, 4}) {
+        benchmarkSharedLane(pucks);
+        benchmarkHmdLane(pucks);
+    }
+}
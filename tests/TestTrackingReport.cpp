@@ -0,0 +1,154 @@
+/** @file
+    @brief Test - the packed tracking report's rotation precision, and a
+    benchmark of the bytes it moves against the unpacked report.
+
+    @date 2017
+
+    @author
+    Sensics, Inc.
+    <http://sensics.com/osvr>
+*/
+
+// Copyright 2017 Sensics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Internal Includes
+#include "QuickProcessingRing.h"
+#include "TrackingReport.h"
+#include <osvr/Util/TimeValue.h>
+
+// Library/third-party includes
+#include <catch2/catch.hpp>
+#include <openvr_driver.h>
+#include <osvr/Util/EigenCoreGeometry.h>
+
+// Standard includes
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+
+using namespace osvr::vive;
+
+namespace {
+    /// TrackingReport as it was before packing: a whole vr::DriverPose_t.
+    struct UnpackedTrackingReport {
+        bool isUniverseChange = false;
+        std::uint64_t newUniverse;
+        OSVR_TimeValue timestamp;
+        OSVR_ChannelCount sensor;
+        vr::DriverPose_t report;
+    };
+
+    /// Fills a pose record the way ViveDriverHost::submitTrackingReport does.
+    TrackingReport packPose(OSVR_ChannelCount sensor, std::int64_t nowNs,
+                            vr::DriverPose_t const &newPose) {
+        TrackingReport out;
+        out.kind = TrackingReport::Kind::Pose;
+        out.poseIsValid = newPose.poseIsValid;
+        out.result = static_cast<std::int16_t>(newPose.result);
+        out.sensor = sensor;
+        out.pose.timestampNs = nowNs;
+        out.pose.latencyUs = 0;
+        std::copy_n(newPose.vecPosition, 3, out.pose.position);
+        out.pose.rotation[0] = static_cast<float>(newPose.qRotation.w);
+        out.pose.rotation[1] = static_cast<float>(newPose.qRotation.x);
+        out.pose.rotation[2] = static_cast<float>(newPose.qRotation.y);
+        out.pose.rotation[3] = static_cast<float>(newPose.qRotation.z);
+        return out;
+    }
+
+    UnpackedTrackingReport unpackedPose(OSVR_ChannelCount sensor,
+                                        std::int64_t nowNs,
+                                        vr::DriverPose_t const &newPose) {
+        UnpackedTrackingReport out;
+        out.timestamp.seconds = nowNs / 1000000000;
+        out.timestamp.microseconds =
+            static_cast<OSVR_TimeValue_Microseconds>(nowNs % 1000000000 /
+                                                     1000);
+        out.sensor = sensor;
+        out.report = newPose;
+        return out;
+    }
+
+    /// What the main thread reads from each.
+    double readPose(TrackingReport const &report) {
+        return report.pose.position[0] + report.pose.rotation[0] +
+               static_cast<double>(report.pose.timestampNs);
+    }
+    double readPose(UnpackedTrackingReport const &report) {
+        return report.report.vecPosition[0] + report.report.qRotation.w +
+               static_cast<double>(report.timestamp.seconds);
+    }
+
+    /// One update's worth of poses - built at callback time, copied into the
+    /// queue, grabbed out of it, and read - for a number of sensors.
+    template <typename Report, typename F>
+    void benchmarkPoses(std::string const &name, std::size_t sensors,
+                        F &&build) {
+        QuickProcessingRing<Report> queue(64);
+        vr::DriverPose_t pose = {};
+        pose.qRotation.w = 1.;
+        pose.poseIsValid = true;
+        pose.result = vr::TrackingResult_Running_OK;
+        /// Built, copied in, copied out.
+        auto bytes = sensors * sizeof(Report) * 3;
+        BENCHMARK(name + ", " + std::to_string(sensors) + " sensors (" +
+                  std::to_string(bytes) + " bytes)") {
+            for (std::size_t i = 0; i < sensors; ++i) {
+                queue.submitNew(build(static_cast<OSVR_ChannelCount>(i),
+                                      static_cast<std::int64_t>(i), pose));
+            }
+            queue.grabItems();
+            double ret = 0;
+            for (auto const &report : queue.accessWorkItems()) {
+                ret += readPose(report);
+            }
+            return ret;
+        };
+    }
+} // namespace
+
+TEST_CASE("Packed pose rotations stay within 2e-7 radians") {
+    std::mt19937 engine(5);
+    std::normal_distribution<double> normal;
+    vr::DriverPose_t pose = {};
+    double worst = 0;
+    for (int i = 0; i < 10000; ++i) {
+        Eigen::Quaterniond q(normal(engine), normal(engine), normal(engine),
+                             normal(engine));
+        q.normalize();
+        pose.qRotation.w = q.w();
+        pose.qRotation.x = q.x();
+        pose.qRotation.y = q.y();
+        pose.qRotation.z = q.z();
+        auto packed = packPose(0, 0, pose);
+        Eigen::Quaterniond widened(
+            packed.pose.rotation[0], packed.pose.rotation[1],
+            packed.pose.rotation[2], packed.pose.rotation[3]);
+        worst = std::max(worst, q.angularDistance(widened.normalized()));
+    }
+    REQUIRE(worst < 2e-7);
+}
+
+/// Hidden: run with `ViveTests [benchmark]`. Bytes per second is the bytes in
+/// each name over its mean time.
+TEST_CASE("Tracking report benchmark: packed against unpacked",
+          "[.][benchmark]") {
+    for (std::size_t sensors : {3, 8, 16}) {
+        benchmarkPoses<TrackingReport>("packed", sensors, packPose);
+        benchmarkPoses<UnpackedTrackingReport>("unpacked", sensors,
+                                               unpackedPose);
+    }
+}